@@ -0,0 +1,79 @@
+/* tracedump.c 
+ *
+ * This program prints a Nachos system call trace file, as written by
+ * the TraceDump system call or by "nachos -tr <file>", one call per line:
+ *
+ *	seq pid name(args) = result  [entry ticks +ticks taken]
+ *
+ * A call that had not returned when the trace was written (or that never
+ * does, like Exit) is shown without a result.  The file is read in the
+ * byte order of the host, so run this where Nachos ran.
+ *
+ * Copyright (c) 1992-1993 The Regents of the University of California.
+ * All rights reserved.  See copyright.h for copyright notice and limitation 
+ * of liability and disclaimer of warranty provisions.
+ */
+
+#define MAIN
+#include "copyright.h" 
+#undef MAIN
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "tracefmt.h"
+
+int
+main(int argc, char **argv)
+{
+    FILE *fp;
+    TraceHeader header;
+    TraceRecord rec;
+    char *names;
+    int i, j;
+
+    if (argc != 2) {
+	fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+	exit(1);
+    }
+    if ((fp = fopen(argv[1], "rb")) == NULL) {
+	perror(argv[1]);
+	exit(1);
+    }
+    if (fread(&header, sizeof(header), 1, fp) != 1 
+	    || header.traceMagic != TRACEMAGIC || header.numNames < 0) {
+	fprintf(stderr, "%s: not a Nachos trace file\n", argv[1]);
+	exit(1);
+    }
+    names = malloc(header.numNames * TraceNameLen);
+    if (fread(names, TraceNameLen, header.numNames, fp) != header.numNames) {
+	fprintf(stderr, "%s: truncated\n", argv[1]);
+	exit(1);
+    }
+
+    printf("%d system calls", header.numRecords);
+    if (header.dropped > 0)
+	printf(" (%d earlier ones overwritten)", header.dropped);
+    printf("\n");
+    for (i = 0; i < header.numRecords; i++) {
+	if (fread(&rec, sizeof(rec), 1, fp) != 1) {
+	    fprintf(stderr, "%s: truncated\n", argv[1]);
+	    exit(1);
+	}
+	printf("%8u %4d ", rec.seq, rec.pid);
+	if (rec.code >= 0 && rec.code < header.numNames 
+		&& names[rec.code * TraceNameLen] != '\0')
+	    printf("%s(", &names[rec.code * TraceNameLen]);
+	else
+	    printf("syscall%d(", rec.code);
+	for (j = 0; j < rec.numArgs && j < TraceMaxArgs; j++)
+	    printf(j == 0 ? "%#x" : ", %#x", rec.args[j]);
+	if (!rec.returned)
+	    printf(")  [%llu]\n", rec.entryTicks);
+	else
+	    printf(") = %d  [%llu +%llu]\n", rec.result, rec.entryTicks, 
+		rec.exitTicks - rec.entryTicks);
+    }
+    fclose(fp);
+    return 0;
+}
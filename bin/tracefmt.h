@@ -0,0 +1,37 @@
+/* tracefmt.h 
+ *     Data structures defining the Nachos system call trace file.
+ *
+ *     The kernel keeps a record of every system call in a ring (see
+ *     userprog/systrace.cc), and writes the ring out as a trace file
+ *     on request; tracedump prints one.  A trace file is a TraceHeader,
+ *     then the names of the system calls, "numNames" of them, each
+ *     TraceNameLen bytes, then "numRecords" TraceRecords, oldest first.
+ *     Everything is in the byte order of the host that wrote it.
+ */
+
+#define TRACEMAGIC	0x5ca11ed		/* denotes a trace file */
+
+#define TraceNameLen	12	/* bytes per system call name */
+#define TraceMaxArgs	4	/* as many as the argument registers */
+
+typedef struct traceHeader {
+   int traceMagic;		/* should be TRACEMAGIC */
+   int numNames;		/* system call codes named in the file */
+   int numRecords;		/* records in the file */
+   int dropped;			/* older records the ring overwrote */
+} TraceHeader;
+
+typedef struct traceRecord {
+   unsigned int seq;		/* which call this was, from 0 */
+   int pid;			/* process that made it */
+   int code;			/* system call code, from syscall.h */
+   int numArgs;			/* how many of "args" it takes */
+   int args[TraceMaxArgs];
+   int result;			/* returned in r2, once it has returned */
+   int returned;		/* 0 if it had not returned, or never 
+				 * does (Exit, Halt); "result" and 
+				 * "exitTicks" are only set if it has 
+				 */
+   unsigned long long entryTicks;	/* simulated time of the call */
+   unsigned long long exitTicks;	/* and of its return */
+} TraceRecord;
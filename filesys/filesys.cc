@@ -50,6 +50,9 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#ifdef CHANGED
+#include "synch.h"
+#endif
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known 
@@ -80,6 +83,9 @@
 FileSystem::FileSystem(bool format)
 { 
     DEBUG('f', "Initializing the file system.\n");
+#ifdef CHANGED
+    dirLock = new RWLock("file system directory");
+#endif
     if (format) {
         BitMap *freeMap = new BitMap(NumSectors);
         Directory *directory = new Directory(NumDirEntries);
@@ -165,7 +171,8 @@ FileSystem::FileSystem(bool format)
 //	 	no free space for data blocks for the file 
 //
 // 	Note that this implementation assumes there is no concurrent access
-//	to the file system!
+//	to the file system!  (Under CHANGED, dirLock is held for writing
+//	throughout, which makes that so.)
 //
 //	"name" -- name of file to be created
 //	"initialSize" -- size of file to be created
@@ -182,6 +189,9 @@ FileSystem::Create(char *name, int initialSize)
 
     DEBUG('f', "Creating file %s, size %d\n", name, initialSize);
 
+#ifdef CHANGED
+    dirLock->AcquireWrite();
+#endif
     directory = new Directory(NumDirEntries);
     directory->FetchFrom(directoryFile);
 
@@ -211,6 +221,9 @@ FileSystem::Create(char *name, int initialSize)
         delete freeMap;
     }
     delete directory;
+#ifdef CHANGED
+    dirLock->ReleaseWrite();
+#endif
     return success;
 }
 
@@ -232,10 +245,16 @@ FileSystem::Open(char *name)
     OpenFile *openFile = NULL;
     int sector;
     DEBUG('f', "Opening file %s\n", name);
+#ifdef CHANGED
+    dirLock->AcquireRead();		// lookups can go on side by side
+#endif
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name); 
     if (sector >= 0) 		
 		openFile = new OpenFile(sector);	// name was found in directory 
+#ifdef CHANGED
+    dirLock->ReleaseRead();
+#endif
     delete directory;
     return openFile;				// return NULL if not found
 }
@@ -251,6 +270,10 @@ FileSystem::Open(char *name)
 //	Return TRUE if the file was deleted, FALSE if the file wasn't
 //	in the file system.
 //
+//	The name is looked up holding dirLock only for reading, so that
+//	removing a file that isn't there doesn't hold up anybody; the
+//	hold is upgraded once there is something to change.
+//
 //	"name" -- the text name of the file to be removed
 //----------------------------------------------------------------------
 
@@ -263,8 +286,23 @@ FileSystem::Remove(char *name)
     int sector;
     
     directory = new Directory(NumDirEntries);
+#ifdef CHANGED
+    dirLock->AcquireRead();
+#endif
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name);
+#ifdef CHANGED
+    if (sector != -1 && !dirLock->Upgrade()) {
+	// another remover is upgrading; wait our turn and look again
+	dirLock->ReleaseRead();
+	dirLock->AcquireWrite();
+	directory->FetchFrom(directoryFile);
+	sector = directory->Find(name);
+	if (sector == -1)
+	    dirLock->ReleaseWrite();
+    } else if (sector == -1)
+	dirLock->ReleaseRead();
+#endif
     if (sector == -1) {
        delete directory;
        return FALSE;			 // file not found 
@@ -281,6 +319,9 @@ FileSystem::Remove(char *name)
 
     freeMap->WriteBack(freeMapFile);		// flush to disk
     directory->WriteBack(directoryFile);        // flush to disk
+#ifdef CHANGED
+    dirLock->ReleaseWrite();
+#endif
     delete fileHdr;
     delete directory;
     delete freeMap;
@@ -297,7 +338,13 @@ FileSystem::List()
 {
     Directory *directory = new Directory(NumDirEntries);
 
+#ifdef CHANGED
+    dirLock->AcquireRead();
+#endif
     directory->FetchFrom(directoryFile);
+#ifdef CHANGED
+    dirLock->ReleaseRead();
+#endif
     directory->List();
     delete directory;
 }
@@ -65,6 +65,10 @@ class FileSystem {
 };
 
 #else // FILESYS
+#ifdef CHANGED
+class RWLock;
+#endif
+
 class FileSystem {
   public:
     FileSystem(bool format);		// Initialize the file system.
@@ -90,6 +94,11 @@ class FileSystem {
 					// represented as a file
    OpenFile* directoryFile;		// "Root" directory -- list of 
 					// file names, represented as a file
+#ifdef CHANGED
+   RWLock* dirLock;			// held for reading to look names up,
+					// for writing to change the directory
+					// or the bitmap
+#endif
 };
 
 #endif // FILESYS
@@ -98,13 +98,19 @@ OpenFile::Write(char *into, int numBytes)
 //	sector at a time.  Thus:
 //
 //	For ReadAt:
-//	   We read in all of the full or partial sectors that are part of the
-//	   request, but we only copy the part we are interested in.
+//	   Sectors wholly covered by the request are read straight into
+//	   the caller's buffer.  Only a partial first or last sector is
+//	   read into a one-sector bounce buffer, from which we copy the
+//	   part we are interested in.
 //	For WriteAt:
-//	   We must first read in any sectors that will be partially written,
-//	   so that we don't overwrite the unmodified portion.  We then copy
-//	   in the data that will be modified, and write back all the full
-//	   or partial sectors that are part of the request.
+//	   Sectors wholly covered by the request are written straight from
+//	   the caller's buffer.  A partial first or last sector must first
+//	   be read in, so that we don't overwrite the unmodified portion,
+//	   then patched in the bounce buffer and written back.
+//
+//	When the caller's buffer is a user page frame (see
+//	AddrSpace::read_file/write_file), sector-aligned transfers never
+//	touch an intermediate kernel buffer.
 //
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
@@ -117,8 +123,8 @@ int
 OpenFile::ReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    char *buf;
+    int i, firstSector, lastSector, start, end;
+    char bounce[SectorSize];
 
     if ((numBytes <= 0) || (position >= fileLength))
     	return 0; 				// check request
@@ -129,17 +135,21 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
 	
     firstSector = divRoundDown(position, SectorSize);
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-
-    // read in all the full and partial sectors that we need
-    buf = new char[numSectors * SectorSize];
-    for (i = firstSector; i <= lastSector; i++)	
-        synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
 
-    // copy the part we want
-    bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
-    delete [] buf;
+    // whole sectors go straight into the caller's buffer; only a 
+    // partial first or last sector goes through the bounce buffer
+    for (i = firstSector; i <= lastSector; i++) {
+	start = (i == firstSector) ? position : i * SectorSize;
+	end = (i == lastSector) ? position + numBytes : (i + 1) * SectorSize;
+	if (end - start == SectorSize)
+	    synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
+					&into[start - position]);
+	else {
+	    synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), bounce);
+	    bcopy(&bounce[start - i * SectorSize], &into[start - position], 
+					end - start);
+	}
+    }
     return numBytes;
 }
 
@@ -147,9 +157,8 @@ int
 OpenFile::WriteAt(char *from, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    bool firstAligned, lastAligned;
-    char *buf;
+    int i, firstSector, lastSector, start, end;
+    char bounce[SectorSize];
 
     if ((numBytes <= 0) || (position >= fileLength))
 	return 0;				// check request
@@ -160,28 +169,22 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
 
     firstSector = divRoundDown(position, SectorSize);
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-
-    buf = new char[numSectors * SectorSize];
-
-    firstAligned = (position == (firstSector * SectorSize));
-    lastAligned = ((position + numBytes) == ((lastSector + 1) * SectorSize));
-
-// read in first and last sector, if they are to be partially modified
-    if (!firstAligned)
-        ReadAt(buf, SectorSize, firstSector * SectorSize);	
-    if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize], 
-				SectorSize, lastSector * SectorSize);	
-
-// copy in the bytes we want to change 
-    bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
 
-// write modified sectors back
-    for (i = firstSector; i <= lastSector; i++)	
-        synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
-    delete [] buf;
+    // whole sectors are written straight from the caller's buffer; a
+    // partial first or last sector has to be read, modified and written
+    for (i = firstSector; i <= lastSector; i++) {
+	start = (i == firstSector) ? position : i * SectorSize;
+	end = (i == lastSector) ? position + numBytes : (i + 1) * SectorSize;
+	if (end - start == SectorSize)
+	    synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
+					&from[start - position]);
+	else {
+	    synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), bounce);
+	    bcopy(&from[start - position], &bounce[start - i * SectorSize], 
+					end - start);
+	    synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), bounce);
+	}
+    }
     return numBytes;
 }
 
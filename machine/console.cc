@@ -34,10 +34,12 @@ static void ConsoleWriteDone(int c)
 // 	"writeDone" is the interrupt handler called when a character has
 //		been output, so that it is ok to request the next char be
 //		output
+//	"pollInput" -- if FALSE, the keyboard is never polled, so that
+//		an output-only console does not keep Nachos from idling
 //----------------------------------------------------------------------
 
 Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail, 
-		VoidFunctionPtr writeDone, int callArg)
+		VoidFunctionPtr writeDone, int callArg, bool pollInput)
 {
     if (readFile == NULL)
 	readFileNo = 0;					// keyboard = stdin
@@ -53,10 +55,13 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
     readHandler = readAvail;
     handlerArg = callArg;
     putBusy = FALSE;
+    putCount = 0;
     incoming = EOF;
+    polling = pollPending = FALSE;
 
     // start polling for incoming packets
-    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, ConsoleReadInt);
+    if (pollInput)
+	StartPolling();
 }
 
 //----------------------------------------------------------------------
@@ -89,8 +94,12 @@ Console::CheckCharAvail()
     char c;
 
     // schedule the next time to poll for a packet
-    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
+    pollPending = FALSE;
+    if (polling) {
+	interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
 			ConsoleReadInt);
+	pollPending = TRUE;
+    }
 
     // do nothing if character is already buffered, or none to be read
     if ((incoming != EOF) || !PollFile(readFileNo))
@@ -103,18 +112,44 @@ Console::CheckCharAvail()
     (*readHandler)(handlerArg);	
 }
 
+//----------------------------------------------------------------------
+// Console::StartPolling()
+// Console::StopPolling()
+// 	Turn polling of the simulated keyboard on and off.  While the 
+//	keyboard is being polled there is always an interrupt pending, 
+//	so Nachos never runs out of things to do; a kernel that only 
+//	needs input now and then polls only while someone is waiting.
+//----------------------------------------------------------------------
+
+void
+Console::StartPolling()
+{
+    polling = TRUE;
+    if (!pollPending) {
+	interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
+			ConsoleReadInt);
+	pollPending = TRUE;
+    }
+}
+
+void
+Console::StopPolling()
+{
+    polling = FALSE;		// the pending poll, if any, is the last
+}
+
 //----------------------------------------------------------------------
 // Console::WriteDone()
 // 	Internal routine called when it is time to invoke the interrupt
-//	handler to tell the Nachos kernel that the output character has
-//	completed.
+//	handler to tell the Nachos kernel that the output character (or
+//	characters, after PutChars) has completed.
 //----------------------------------------------------------------------
 
 void
 Console::WriteDone()
 {
     putBusy = FALSE;
-    stats->numConsoleCharsWritten++;
+    stats->numConsoleCharsWritten += putCount;
     (*writeHandler)(handlerArg);
 }
 
@@ -145,6 +180,29 @@ Console::PutChar(char ch)
     ASSERT(putBusy == FALSE);
     WriteFile(writeFileNo, &ch, sizeof(char));
     putBusy = TRUE;
+    putCount = 1;
+    interrupt->Schedule(ConsoleWriteDone, (int)this, ConsoleTime,
+					ConsoleWriteInt);
+}
+
+//----------------------------------------------------------------------
+// Console::PutChars()
+// 	Write a burst of characters to the simulated display, schedule
+//	a single interrupt to occur in the future, and return.  Like
+//	PutChar, but the whole burst completes with one interrupt.
+//
+//	"buf" -- the characters to write
+//	"count" -- how many of them
+//----------------------------------------------------------------------
+
+void
+Console::PutChars(char *buf, int count)
+{
+    ASSERT(putBusy == FALSE);
+    ASSERT(count > 0);
+    WriteFile(writeFileNo, buf, count);
+    putBusy = TRUE;
+    putCount = count;
     interrupt->Schedule(ConsoleWriteDone, (int)this, ConsoleTime,
 					ConsoleWriteInt);
 }
@@ -38,7 +38,7 @@
 class Console {
   public:
     Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail, 
-	VoidFunctionPtr writeDone, int callArg);
+	VoidFunctionPtr writeDone, int callArg, bool pollInput = TRUE);
 				// initialize the hardware console device
     ~Console();			// clean up console emulation
 
@@ -46,12 +46,19 @@ class Console {
     void PutChar(char ch);	// Write "ch" to the console display, 
 				// and return immediately.  "writeHandler" 
 				// is called when the I/O completes. 
+    void PutChars(char *buf, int count);
+				// Write a burst of characters; "writeHandler"
+				// is called once, when all of them are done.
 
     char GetChar();	   	// Poll the console input.  If a char is 
 				// available, return it.  Otherwise, return EOF.
     				// "readHandler" is called whenever there is 
 				// a char to be gotten
 
+    void StartPolling();	// Start or stop checking the keyboard for 
+    void StopPolling();		// input; "readHandler" is only called 
+				// while polling
+
 // internal emulation routines -- DO NOT call these. 
     void WriteDone();	 	// internal routines to signal I/O completion
     void CheckCharAvail();
@@ -67,6 +74,10 @@ class Console {
 					// interrupt handlers
     bool putBusy;    			// Is a PutChar operation in progress?
 					// If so, you can't do another one!
+    int putCount;			// How many characters the operation
+					// in progress is writing
+    bool polling;			// Is the keyboard being polled?
+    bool pollPending;			// Is a keyboard poll scheduled?
     char incoming;    			// Contains the character to be read,
 					// if there is one available. 
 					// Otherwise contains EOF.
@@ -23,12 +23,15 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "system.h"
+#ifdef USER_PROGRAM
+#include "syscalltable.h"
+#endif
 
 // String definitions for debugging messages
 
 static const char *intLevelNames[] = { "off", "on"};
 static const char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "network send", "network recv", "alarm"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -242,6 +245,9 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+#ifdef USER_PROGRAM
+    PrintSyscallStats();
+#endif
     Cleanup();     // Never returns.
 }
 
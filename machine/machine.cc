@@ -71,6 +71,8 @@ Machine::Machine(bool debug)
     pageTable = NULL;
 #endif
 
+    linked = FALSE;
+    linkedAddr = 0;
     singleStep = debug;
     CheckEndian();
 }
@@ -105,6 +107,7 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
 //  ASSERT(interrupt->getStatus() == UserMode);
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
+    linked = FALSE;			// a trap breaks any LL/SC pair
     interrupt->setStatus(SystemMode);
     ExceptionHandler(which);		// interrupts are enabled at this point
     interrupt->setStatus(UserMode);
@@ -157,6 +157,10 @@ class Machine {
 				// code and data, while executing
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
+    bool linked;		// an LL's reservation is still good: no
+				// trap or context switch since it ran
+    int linkedAddr;		// the virtual address it was made on
+
 
 // NOTE: the hardware translation of virtual addresses in the user program
 // to physical addresses (relative to the beginning of "mainMemory")
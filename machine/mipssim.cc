@@ -277,6 +277,23 @@ Machine::OneInstruction(Instruction *instr)
 	nextLoadValue = value;
 	break;
     	
+      case OP_LL:
+	// A load like LW, that also notes where it was made.  With one
+	// simulated CPU, the only things that can come between it and
+	// the SC are a trap and a context switch, and both clear "linked".
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (!machine->ReadMem(tmp, 4, &value))
+	    return;
+	linked = TRUE;
+	linkedAddr = tmp;
+	nextLoadReg = instr->rt;
+	nextLoadValue = value;
+	break;
+
       case OP_LWL:	  
 	tmp = registers[instr->rs] + instr->extra;
 
@@ -474,6 +491,23 @@ Machine::OneInstruction(Instruction *instr)
 	    return;
 	break;
 	
+      case OP_SC:
+	// Store only if the reservation made by LL still stands, and
+	// leave 1 in rt if it did, 0 if not.
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (linked && linkedAddr == tmp) {
+	    if (!machine->WriteMem(tmp, 4, registers[instr->rt]))
+		return;
+	    registers[instr->rt] = 1;
+	} else
+	    registers[instr->rt] = 0;
+	linked = FALSE;
+	break;
+	
       case OP_SWL:	  
 	tmp = registers[instr->rs] + instr->extra;
 
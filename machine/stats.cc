@@ -11,6 +11,125 @@
 #include "utility.h"
 #include "stats.h"
 
+static char *faultTypeNames[] = { "zeroFill", "code", "initData", "swapIn" };
+
+// Per process VM counters, as kept on Statistics::processVM.
+class ProcessVM {
+  public:
+    char name[32];
+    int pid;
+    VMStats vm;
+};
+
+//----------------------------------------------------------------------
+// VMStats::VMStats
+// 	Initialize the virtual memory event counters to zero.
+//----------------------------------------------------------------------
+
+VMStats::VMStats()
+{
+    zeroFillFaults = codeFaults = dataFaults = swapInFaults = 0;
+    cleanEvictions = dirtyEvictions = 0;
+    swapReads = swapWrites = 0;
+    faultTicks = 0;
+    for (int i = 0; i < VMLatencyBuckets; i++)
+	latency[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// VMStats::Faults
+// 	Return the number of faults serviced, of any type.
+//----------------------------------------------------------------------
+
+int
+VMStats::Faults()
+{
+    return zeroFillFaults + codeFaults + dataFaults + swapInFaults;
+}
+
+//----------------------------------------------------------------------
+// VMStats::RecordFault
+// 	Count one serviced page fault.
+//
+//	"type" is where the contents of the faulted page came from
+//	"ticks" is how much simulated time it took to service the fault
+//----------------------------------------------------------------------
+
+void
+VMStats::RecordFault(VMFaultType type, unsigned long long ticks)
+{
+    int bucket = 0;
+
+    switch (type) {
+      case ZeroFillFault:	zeroFillFaults++; break;
+      case CodeFault:		codeFaults++; break;
+      case DataFault:		dataFaults++; break;
+      case SwapInFault:		swapInFaults++; break;
+    }
+    faultTicks += ticks;
+    while (bucket < VMLatencyBuckets - 1 && (ticks >> (bucket + 1)) != 0)
+	bucket++;
+    latency[bucket]++;
+}
+
+//----------------------------------------------------------------------
+// VMStats::Print
+// 	Print the virtual memory counters, each line prefixed by "indent".
+//----------------------------------------------------------------------
+
+void
+VMStats::Print(char *indent)
+{
+    int faults = Faults();
+
+    printf("%sFaults: %s %d, %s %d, %s %d, %s %d\n", indent,
+	faultTypeNames[ZeroFillFault], zeroFillFaults, 
+	faultTypeNames[CodeFault], codeFaults,
+	faultTypeNames[DataFault], dataFaults, 
+	faultTypeNames[SwapInFault], swapInFaults);
+    printf("%sEvictions: clean %d, dirty %d\n", indent, cleanEvictions, 
+	dirtyEvictions);
+    printf("%sSwap I/O: reads %d, writes %d\n", indent, swapReads, 
+	swapWrites);
+    if (faults == 0)
+	return;
+    printf("%sFault latency: average %llu ticks\n", indent, 
+	faultTicks / faults);
+    for (int i = 0; i < VMLatencyBuckets; i++) {
+	if (latency[i] == 0)
+	    continue;
+	if (i == VMLatencyBuckets - 1)
+	    printf("%s  >= %llu ticks: %d\n", indent, 1ULL << i, latency[i]);
+	else
+	    printf("%s  < %llu ticks: %d\n", indent, 2ULL << i, latency[i]);
+    }
+}
+
+//----------------------------------------------------------------------
+// VMStats::PrintJSON
+// 	Write the virtual memory counters to "out", as a JSON object.
+//----------------------------------------------------------------------
+
+void
+VMStats::PrintJSON(FILE *out)
+{
+    int faults[] = { zeroFillFaults, codeFaults, dataFaults, swapInFaults };
+
+    fprintf(out, "{\"faults\": {");
+    for (int t = ZeroFillFault; t <= SwapInFault; t++)
+	fprintf(out, "%s\"%s\": %d", (t == ZeroFillFault) ? "" : ", ",
+	    faultTypeNames[t], faults[t]);
+    fprintf(out, "}, \"evictions\": {\"clean\": %d, \"dirty\": %d}",
+	cleanEvictions, dirtyEvictions);
+    fprintf(out, ", \"swap\": {\"reads\": %d, \"writes\": %d}", 
+	swapReads, swapWrites);
+    fprintf(out, ", \"faultTicks\": %llu, \"latencyHistogram\": [", 
+	faultTicks);
+    for (int i = 0; i < VMLatencyBuckets; i++)
+	fprintf(out, "%s%d", (i == 0) ? "" : ", ", latency[i]);
+    fprintf(out, "]}");
+}
+
 //----------------------------------------------------------------------
 // Statistics::Statistics
 // 	Initialize performance metrics to zero, at system startup.
@@ -22,6 +141,63 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    jsonFile = NULL;
+    processVM = new List;
+}
+
+//----------------------------------------------------------------------
+// Statistics::NewProcessVM
+// 	Allocate the VM counters for a new process.  The counters stay
+//	around after the process exits, so that they can be reported
+//	when Nachos halts.
+//
+//	"name" is the name of the executable the process is running
+//	"pid" is the process identifier, or -1 if it has none
+//----------------------------------------------------------------------
+
+VMStats *
+Statistics::NewProcessVM(char *name, int pid)
+{
+    ProcessVM *proc = new ProcessVM;
+
+    strncpy(proc->name, name, sizeof(proc->name) - 1);
+    proc->name[sizeof(proc->name) - 1] = '\0';
+    proc->pid = pid;
+    processVM->Append((void *)proc);
+    return &proc->vm;
+}
+
+//----------------------------------------------------------------------
+// PrintProcessVM, PrintProcessVMJSON
+// 	Helpers for Statistics::Print and Statistics::PrintJSON, to
+//	print the VM counters of one process.
+//----------------------------------------------------------------------
+
+static void
+PrintProcessVM(int arg)
+{
+    ProcessVM *proc = (ProcessVM *)arg;
+
+    if (proc->vm.Faults() == 0 && proc->vm.cleanEvictions == 0 
+		&& proc->vm.dirtyEvictions == 0)
+	return;
+    printf("  Process %d (%s):\n", proc->pid, proc->name);
+    proc->vm.Print("    ");
+}
+
+static FILE *jsonOut;
+static bool jsonFirst;
+
+static void
+PrintProcessVMJSON(int arg)
+{
+    ProcessVM *proc = (ProcessVM *)arg;
+
+    fprintf(jsonOut, "%s\n    {\"pid\": %d, \"name\": \"%s\", \"vm\": ", 
+	jsonFirst ? "" : ",", proc->pid, proc->name);
+    proc->vm.PrintJSON(jsonOut);
+    fprintf(jsonOut, "}");
+    jsonFirst = FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -39,6 +215,47 @@ Statistics::Print()
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("Paging: faults %d\n", numPageFaults);
+    vm.Print("  ");
+    processVM->Mapcar(PrintProcessVM);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
+    if (jsonFile != NULL)
+	PrintJSON(jsonFile);
+}
+
+//----------------------------------------------------------------------
+// Statistics::PrintJSON
+// 	Dump the collected statistics, including the system wide and
+//	per process VM counters, as a JSON document.
+//
+//	"fileName" is the UNIX file to write; "-" means stdout
+//----------------------------------------------------------------------
+
+void
+Statistics::PrintJSON(char *fileName)
+{
+    if (!strcmp(fileName, "-"))
+	jsonOut = stdout;
+    else if ((jsonOut = fopen(fileName, "w")) == NULL) {
+	printf("Unable to open statistics file %s\n", fileName);
+	return;
+    }
+    fprintf(jsonOut, "{\n  \"ticks\": {\"total\": %llu, \"idle\": %llu, "
+	"\"system\": %llu, \"user\": %llu},\n", totalTicks, idleTicks, 
+	systemTicks, userTicks);
+    fprintf(jsonOut, "  \"disk\": {\"reads\": %d, \"writes\": %d},\n", 
+	numDiskReads, numDiskWrites);
+    fprintf(jsonOut, "  \"console\": {\"reads\": %d, \"writes\": %d},\n",
+	numConsoleCharsRead, numConsoleCharsWritten);
+    fprintf(jsonOut, "  \"pageFaults\": %d,\n  \"vm\": ", numPageFaults);
+    vm.PrintJSON(jsonOut);
+    fprintf(jsonOut, ",\n  \"processes\": [");
+    jsonFirst = TRUE;
+    processVM->Mapcar(PrintProcessVMJSON);
+    fprintf(jsonOut, "\n  ],\n  \"network\": {\"received\": %d, "
+	"\"sent\": %d}\n}\n", numPacketsRecvd, numPacketsSent);
+    if (jsonOut != stdout)
+	fclose(jsonOut);
+    else
+	fflush(stdout);
 }
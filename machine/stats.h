@@ -12,6 +12,42 @@
 #define STATS_H
 
 #include "copyright.h"
+#include "list.h"
+#include <stdio.h>
+
+// Kinds of demand page fault, by where the contents of the page came from.
+enum VMFaultType { ZeroFillFault, CodeFault, DataFault, SwapInFault };
+
+// Fault service latency is kept as a histogram of simulated ticks.
+// Bucket 0 counts faults serviced in less than 2 ticks, bucket i
+// counts faults serviced in [2^i, 2^(i+1)) ticks, and the last bucket 
+// counts everything slower than that.
+#define VMLatencyBuckets 16
+
+// The following class defines the virtual memory event counters.  One
+// of these is kept for the whole system, and one for every process.
+
+class VMStats {
+  public:
+    int zeroFillFaults;		// pages that started out zero filled
+    int codeFaults;		// pages read in from the code segment
+    int dataFaults;		// pages read in from the initData segment
+    int swapInFaults;		// pages read back in from the swap disk
+    int cleanEvictions;		// victims that were dropped without I/O
+    int dirtyEvictions;		// victims that had to be written out
+    int swapReads;		// sectors read from the swap disk
+    int swapWrites;		// sectors written to the swap disk
+    unsigned long long faultTicks;		// total time spent servicing faults
+    int latency[VMLatencyBuckets];	// fault service time histogram
+
+    VMStats();			// initialize everything to zero
+
+    int Faults();		// sum of the faults of every type
+    void RecordFault(VMFaultType type, unsigned long long ticks);
+				// count a serviced fault and its latency
+    void Print(char *indent);	// print the counters
+    void PrintJSON(FILE *out);	// print the counters as a JSON object
+};
 
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
@@ -36,9 +72,22 @@ class Statistics {
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
+    VMStats vm;			// system wide virtual memory events
+    char *jsonFile;		// if not NULL, Print also dumps the
+				// statistics as JSON into this file
+
     Statistics(); 		// initialize everything to zero
 
     void Print();		// print collected statistics
+    void PrintJSON(char *fileName);	// dump collected statistics as JSON
+
+    VMStats *NewProcessVM(char *name, int pid);
+				// allocate the per process VM counters 
+				// for a new address space; they are 
+				// kept until Nachos halts
+
+  private:
+    List *processVM;		// per process VM counters, in creation order
 };
 
 // Constants used to reflect the relative time an operation would
@@ -0,0 +1,79 @@
+#include "syscall.h"
+/**
+ * test case for the asynchronous file io system calls
+ * (AioRead, AioWrite and AioWait)
+ *
+ * Writes a block to a file in the background while summing an
+ * array, then reads it back the same way and checks it. Also tries
+ * the error cases: console ids, a bad id and a bad handle.
+ */
+#define SIZE 1024
+
+char out[SIZE];
+char in[SIZE];
+int work[SIZE];
+
+prints(char *s, OpenFileId file)
+{
+  while( *s != '\0' )
+  {
+	Write( s, 1, file );
+	++s;
+  }
+}
+
+/* something to do while the disk is busy */
+int compute()
+{
+	int i, sum = 0;
+	for( i = 0; i < SIZE; ++i ) work[i] = i;
+	for( i = 0; i < SIZE; ++i ) sum += work[i];
+	return sum;
+}
+
+int main()
+{
+	int i, sum;
+	AioId aio;
+	OpenFileId fd;
+	
+	for( i = 0; i < SIZE; ++i ) out[i] = 'a' + i % 26;
+	
+	prints( "ASYNC FILE IO TEST CASES\n", ConsoleOutput );
+	
+	/* overlap a write with computation */
+	Create( "dir_test/aioFile" );
+	fd = Open( "dir_test/aioFile" );
+	aio = AioWrite( out, SIZE, fd );
+	sum = compute();
+	if( AioWait( aio ) != SIZE )
+		prints( "AioWrite: short write\n", ConsoleOutput );
+	Close( fd );
+	if( sum != SIZE * ( SIZE - 1 ) / 2 )
+		prints( "compute: wrong sum\n", ConsoleOutput );
+	
+	/* and a read */
+	fd = Open( "dir_test/aioFile" );
+	aio = AioRead( in, SIZE, fd );
+	compute();
+	if( AioWait( aio ) != SIZE )
+		prints( "AioRead: short read\n", ConsoleOutput );
+	Close( fd );
+	for( i = 0; i < SIZE; ++i )
+		if( in[i] != out[i] )
+		{
+			prints( "AioRead: data does not match\n", ConsoleOutput );
+			break;
+		}
+	
+	/* errors: the console, a bad id, a handle already waited for */
+	if( AioRead( in, 1, ConsoleInput ) != -1 )
+		prints( "AioRead on the console should fail\n", ConsoleOutput );
+	if( AioWrite( out, 1, -1 ) != -1 )
+		prints( "AioWrite on a bad id should fail\n", ConsoleOutput );
+	if( AioWait( aio ) != -1 )
+		prints( "AioWait twice should fail\n", ConsoleOutput );
+	
+	prints( "done\n", ConsoleOutput );
+	Exit( 0 );
+}
@@ -0,0 +1,36 @@
+/* fairtest.c
+ *
+ * Simple test of SetWeight, to be run with "nachos -fair".  This
+ * program gives itself four times the ordinary weight and then
+ * computes alongside a kid, so it should get most of the CPU and the
+ * kid's messages should come out near the end of its dots.
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+  SpaceId kid;
+  char *args[2];
+  int i, j;
+
+  if (SetWeight(0) != -1 || SetWeight(4096) != 1024) {
+    Write("SetWeight failed\n", 17, ConsoleOutput);
+    Halt();
+  }
+
+  args[0] = "kid";
+  args[1] = (char *)0;
+  kid = Exec("./test/kid", args);
+
+  for (i = 0; i < 8; i++) {
+    for (j = 0; j < 2000; j++)
+      ;
+    Write(".", 1, ConsoleOutput);
+  }
+  Write("\n", 1, ConsoleOutput);
+  Join(kid);
+  Halt();
+  /* not reached */
+}
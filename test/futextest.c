@@ -0,0 +1,74 @@
+/* futextest.c
+ *
+ * Simple test of CompareAndSwap, FutexWait and FutexWake: three
+ * threads bump a shared counter under a mutex built from them, and
+ * yield while they hold it so that the others have to sleep for it.
+ *
+ * The mutex word is 0 when free, 1 when held, and 2 when held with
+ * threads (maybe) asleep on it; only in that last case does unlocking
+ * trap to wake one of them.
+ */
+
+#include "syscall.h"
+
+#define N	20
+
+int mutex = 0;
+int count = 0;
+volatile int done = 0;
+
+void
+lock()
+{
+  int c;
+
+  if ((c = CompareAndSwap(&mutex, 0, 1)) == 0)
+    return;
+  do {
+    if (c == 2 || CompareAndSwap(&mutex, 1, 2) != 0)
+      FutexWait(&mutex, 2);
+  } while ((c = CompareAndSwap(&mutex, 0, 2)) != 0);
+}
+
+void
+unlock()
+{
+  if (CompareAndSwap(&mutex, 1, 0) != 1) {
+    mutex = 0;
+    FutexWake(&mutex, 1);
+  }
+}
+
+void
+worker()
+{
+  int i, c;
+
+  for (i = 0; i < N; i++) {
+    lock();
+    c = count;
+    Yield();
+    count = c + 1;
+    unlock();
+  }
+  lock();
+  done++;
+  unlock();
+}
+
+int
+main()
+{
+  Fork(worker);
+  Fork(worker);
+  Fork(worker);
+  while (done < 3)
+    Yield();
+
+  if (count == 3 * N)
+    Write("futex ok\n", 9, ConsoleOutput);
+  else
+    Write("futex FAILED\n", 13, ConsoleOutput);
+  Exit(count);
+  /* not reached */
+}
@@ -0,0 +1,27 @@
+/* pipekid.c
+ *
+ * Kid in simple pipe test: copies the pipe named by its argument to
+ * the console until end of file, and reports how much came through.
+ */
+
+#include "syscall.h"
+
+int
+main(int argc, char **argv)
+{
+  OpenFileId in;
+  char buffer[64];
+  int n, total = 0;
+
+  if (argc < 2)
+    Exit(-1);
+  in = argv[1][0] - '0';
+
+  while ((n = Read(buffer, 64, in)) > 0) {
+    Write(buffer, n, ConsoleOutput);
+    total += n;
+  }
+  Close(in);
+  Exit(total);
+  /* not reached */
+}
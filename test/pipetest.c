@@ -0,0 +1,85 @@
+/* pipetest.c
+ *
+ * Parent in simple pipe test.  Makes a pipe, starts pipekid with the
+ * read end (pipe ends are inherited by Exec), closes its own copy of
+ * the read end and streams some lines down the write end.  Closing
+ * the write end is what tells pipekid there is no more.
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+  OpenFileId fds[2];
+  SpaceId kid;
+  char *args[3];
+  char fdname[2];
+  int i;
+
+  if (Pipe(fds) != 0) {
+    prints("PARENT: Pipe failed\n", ConsoleOutput);
+    Halt();
+  }
+  fdname[0] = '0' + fds[0];	/* the ids are small */
+  fdname[1] = '\0';
+  args[0] = "pipekid";
+  args[1] = fdname;
+  args[2] = (char *)0;
+
+  kid = Exec("./test/pipekid", args);
+  Close(fds[0]);
+
+  for (i = 0; i < 20; i++)
+    prints("a line sent down the pipe\n", fds[1]);
+  Close(fds[1]);
+
+  prints("PARENT off Join with value of ", ConsoleOutput);
+  printd(Join(kid), ConsoleOutput);
+  prints("\n", ConsoleOutput);
+
+  /* nobody left to read */
+  Pipe(fds);
+  Close(fds[0]);
+  if (Write("x", 1, fds[1]) != -1)
+    prints("PARENT: write with no reader should fail\n", ConsoleOutput);
+
+  Halt();
+  /* not reached */
+}
+
+/* Print a null-terminated string "s" on open file
+   descriptor "file". */
+
+prints(s,file)
+char *s;
+OpenFileId file;
+
+{
+  int n = 0;
+
+  while (s[n] != '\0')
+    n++;
+  Write(s,n,file);
+}
+
+/* Print an integer "n" on open file descriptor "file". */
+
+printd(n,file)
+int n;
+OpenFileId file;
+
+{
+
+  int i;
+  char c;
+
+  if (n < 0) {
+    Write("-",1,file);
+    n = -n;
+  }
+  if ((i = n/10) != 0)
+    printd(i,file);
+  c = (char) (n % 10) + '0';
+  Write(&c,1,file);
+}
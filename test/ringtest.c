@@ -0,0 +1,91 @@
+#include "syscall.h"
+/**
+ * test case for batched system calls (RingSetup and Enter)
+ *
+ * Queues a Create, Open, Write and Close of a file, runs them with
+ * one Enter, then reads the file back the same way and prints it.
+ * Also checks that a call which may not be batched is refused.
+ */
+#define ENTRIES 8
+
+RingCtl ctl;
+RingSqe sq[ENTRIES];
+RingCqe cq[ENTRIES];
+
+char name[] = "dir_test/ringFile";
+char msg[] = "written through the ring\n";
+char buf[64];
+
+prints(char *s, OpenFileId file)
+{
+  while( *s != '\0' )
+  {
+	Write( s, 1, file );
+	++s;
+  }
+}
+
+/* queue one call; "tag" comes back in its completion */
+submit(int code, int a0, int a1, int a2, int tag)
+{
+	RingSqe *sqe = &sq[ ctl.sqTail % ENTRIES ];
+	sqe->code = code;
+	sqe->args[0] = a0;
+	sqe->args[1] = a1;
+	sqe->args[2] = a2;
+	sqe->userData = tag;
+	ctl.sqTail++;
+}
+
+/* take the next completion, return its result */
+int reap(int tag)
+{
+	RingCqe *cqe = &cq[ ctl.cqHead % ENTRIES ];
+	ctl.cqHead++;
+	if( cqe->userData != tag )
+		prints( "completion out of order\n", ConsoleOutput );
+	return cqe->result;
+}
+
+int main()
+{
+	int i, fd, n;
+	
+	prints( "BATCHED SYSCALL TEST CASES\n", ConsoleOutput );
+	if( Enter( 1 ) != -1 )
+		prints( "Enter before RingSetup should fail\n", ConsoleOutput );
+	if( RingSetup( &ctl, sq, cq, ENTRIES ) != 0 )
+		prints( "RingSetup failed\n", ConsoleOutput );
+	
+	/* the fd is not known until Open completes, so two batches */
+	submit( SC_Create, (int) name, 0, 0, 1 );
+	submit( SC_Open, (int) name, 0, 0, 2 );
+	if( Enter( 2 ) != 2 )
+		prints( "Enter: short batch\n", ConsoleOutput );
+	reap( 1 );
+	fd = reap( 2 );
+	
+	submit( SC_Write, (int) msg, sizeof( msg ) - 1, fd, 3 );
+	submit( SC_Close, fd, 0, 0, 4 );
+	submit( SC_Open, (int) name, 0, 0, 5 );
+	Enter( 3 );
+	if( reap( 3 ) != sizeof( msg ) - 1 )
+		prints( "Write: short write\n", ConsoleOutput );
+	reap( 4 );
+	fd = reap( 5 );
+	
+	for( i = 0; i < 64; ++i ) buf[i] = 0;
+	submit( SC_Read, (int) buf, sizeof( msg ) - 1, fd, 6 );
+	submit( SC_Close, fd, 0, 0, 7 );
+	submit( SC_Halt, 0, 0, 0, 8 );
+	Enter( 3 );
+	n = reap( 6 );
+	reap( 7 );
+	if( reap( 8 ) != -1 )
+		prints( "Halt should not be batched\n", ConsoleOutput );
+	if( n > 0 )
+		prints( buf, ConsoleOutput );
+	
+	prints( "done\n", ConsoleOutput );
+	Exit( 0 );
+}
@@ -1,5 +1,54 @@
 #include "syscall.h"
 
+/* strip the spaces around a program name */
+char *
+trim(char *s)
+{
+    char *end;
+
+    while (*s == ' ') s++;
+    for (end = s; *end != '\0'; end++)
+	;
+    while (end > s && end[-1] == ' ') *--end = '\0';
+    return s;
+}
+
+/* Run "left | right": what left writes to its output, right reads as its
+ * input.  The shell points its own ConsoleOutput, then ConsoleInput, at
+ * an end of a pipe just long enough for Exec to hand it on; Dup always
+ * picks the lowest free id, which is the one just closed.
+ */
+void
+pipeline(char *left, char *right, char *args[])
+{
+    OpenFileId fds[2], saved;
+    SpaceId leftProc, rightProc;
+
+    if (Pipe(fds) == -1)
+	return;
+
+    saved = Dup(ConsoleOutput);
+    Close(ConsoleOutput);
+    Dup(fds[1]);
+    Close(fds[1]);
+    leftProc = Exec(left, args);
+    Close(ConsoleOutput);
+    Dup(saved);
+    Close(saved);
+
+    saved = Dup(ConsoleInput);
+    Close(ConsoleInput);
+    Dup(fds[0]);
+    Close(fds[0]);
+    rightProc = Exec(right, args);
+    Close(ConsoleInput);
+    Dup(saved);
+    Close(saved);
+
+    Join(leftProc);
+    Join(rightProc);
+}
+
 int
 main()
 {
@@ -7,7 +56,7 @@ main()
     OpenFileId input = ConsoleInput;
     OpenFileId output = ConsoleOutput;
     char prompt[2], ch, buffer[60];
-    int i;
+    int i, bar;
 
     prompt[0] = '-';
     prompt[1] = '-';
@@ -30,10 +79,16 @@ main()
 	buffer[--i] = '\0';
 
 	if( i > 0 ) {
+		for( bar = 0; buffer[bar] != '\0' && buffer[bar] != '|'; bar++ )
+			;
+		if( buffer[bar] == '|' ) {
+			buffer[bar] = '\0';
+			pipeline(trim(buffer), trim(&buffer[bar + 1]), args);
+			continue;
+		}
 		newProc = Exec(buffer, args);
 		//newProc = Exec(buffer);
 		Join(newProc);
 	}
     }
 }
-
@@ -0,0 +1,27 @@
+/* shmkid.c
+ *
+ * Kid in simple shared memory test: finds the parent's segment by its
+ * key, adds up the numbers in it and stores the total in the last word.
+ */
+
+#include "syscall.h"
+
+#define KEY	42
+#define WORDS	64
+
+int
+main()
+{
+  int *shared;
+  int i, total = 0;
+
+  shared = (int *) ShmAttach(ShmCreate(KEY, WORDS * sizeof(int)));
+  if (shared == 0)
+    Exit(-1);
+  for (i = 0; i < WORDS - 1; i++)
+    total += shared[i];
+  shared[WORDS - 1] = total;
+  ShmDetach((char *) shared);
+  Exit(total);
+  /* not reached */
+}
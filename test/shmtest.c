@@ -0,0 +1,85 @@
+/* shmtest.c
+ *
+ * Parent in simple shared memory test.  Makes a segment, fills it with
+ * numbers and starts shmkid, which attaches the same segment, adds the
+ * numbers up and leaves the total in the last word.  No file is read
+ * or written; the parent sees the kid's store as soon as it is made.
+ */
+
+#include "syscall.h"
+
+#define KEY	42
+#define WORDS	64		/* two pages */
+
+int
+main()
+{
+  int id, i, expect = 0;
+  int *shared;
+  SpaceId kid;
+  char *args[2];
+
+  id = ShmCreate(KEY, WORDS * sizeof(int));
+  shared = (int *) ShmAttach(id);
+  if (id == -1 || shared == 0) {
+    prints("PARENT: no shared memory\n", ConsoleOutput);
+    Halt();
+  }
+  for (i = 0; i < WORDS - 1; i++) {
+    shared[i] = i;
+    expect += i;
+  }
+
+  args[0] = "shmkid";
+  args[1] = (char *)0;
+  kid = Exec("./test/shmkid", args);
+
+  prints("PARENT off Join with value of ", ConsoleOutput);
+  printd(Join(kid), ConsoleOutput);
+  prints(", shared total ", ConsoleOutput);
+  printd(shared[WORDS - 1], ConsoleOutput);
+  prints(", expected ", ConsoleOutput);
+  printd(expect, ConsoleOutput);
+  prints("\n", ConsoleOutput);
+
+  if (ShmDetach((char *) shared) != 0)
+    prints("PARENT: detach failed\n", ConsoleOutput);
+  Halt();
+  /* not reached */
+}
+
+/* Print a null-terminated string "s" on open file
+   descriptor "file". */
+
+prints(s,file)
+char *s;
+OpenFileId file;
+
+{
+  int n = 0;
+
+  while (s[n] != '\0')
+    n++;
+  Write(s,n,file);
+}
+
+/* Print an integer "n" on open file descriptor "file". */
+
+printd(n,file)
+int n;
+OpenFileId file;
+
+{
+
+  int i;
+  char c;
+
+  if (n < 0) {
+    Write("-",1,file);
+    n = -n;
+  }
+  if ((i = n/10) != 0)
+    printd(i,file);
+  c = (char) (n % 10) + '0';
+  Write(&c,1,file);
+}
@@ -0,0 +1,29 @@
+/* sleeptest.c
+ *
+ * Simple test of Sleep: starts a kid that computes while this program
+ * naps in between printing dots.  The kid should not have to share the
+ * CPU with the sleeper, and the dots should still come out.
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+  SpaceId kid;
+  char *args[2];
+  int i;
+
+  args[0] = "kid";
+  args[1] = (char *)0;
+  kid = Exec("./test/kid", args);
+
+  for (i = 0; i < 5; i++) {
+    Sleep(500);
+    Write(".", 1, ConsoleOutput);
+  }
+  Write("\n", 1, ConsoleOutput);
+  Join(kid);
+  Halt();
+  /* not reached */
+}
@@ -114,14 +114,24 @@ Close:
 	j	$31
 	.end Close
 
+/* Fork also hands the kernel the address of ThreadExit, for the new
+ * thread to return to when its procedure is done.
+ */
 	.globl Fork
 	.ent	Fork
 Fork:
+	la	$5,ThreadExit
 	addiu $2,$0,SC_Fork
 	syscall
 	j	$31
 	.end Fork
 
+	.ent	ThreadExit
+ThreadExit:
+	move	$4,$0
+	jal	Exit	 /* if we return from a forked procedure, exit(0) */
+	.end ThreadExit
+
 	.globl Yield
 	.ent	Yield
 Yield:
@@ -130,6 +140,160 @@ Yield:
 	j	$31
 	.end Yield
 
+	.globl AioRead
+	.ent	AioRead
+AioRead:
+	addiu $2,$0,SC_AioRead
+	syscall
+	j	$31
+	.end AioRead
+
+	.globl AioWrite
+	.ent	AioWrite
+AioWrite:
+	addiu $2,$0,SC_AioWrite
+	syscall
+	j	$31
+	.end AioWrite
+
+	.globl AioWait
+	.ent	AioWait
+AioWait:
+	addiu $2,$0,SC_AioWait
+	syscall
+	j	$31
+	.end AioWait
+
+	.globl RingSetup
+	.ent	RingSetup
+RingSetup:
+	addiu $2,$0,SC_RingSetup
+	syscall
+	j	$31
+	.end RingSetup
+
+	.globl Enter
+	.ent	Enter
+Enter:
+	addiu $2,$0,SC_Enter
+	syscall
+	j	$31
+	.end Enter
+
+	.globl Pipe
+	.ent	Pipe
+Pipe:
+	addiu $2,$0,SC_Pipe
+	syscall
+	j	$31
+	.end Pipe
+
+	.globl WaitAny
+	.ent	WaitAny
+WaitAny:
+	addiu $2,$0,SC_WaitAny
+	syscall
+	j	$31
+	.end WaitAny
+
+	.globl Dup
+	.ent	Dup
+Dup:
+	addiu $2,$0,SC_Dup
+	syscall
+	j	$31
+	.end Dup
+
+	.globl TraceDump
+	.ent	TraceDump
+TraceDump:
+	addiu $2,$0,SC_TraceDump
+	syscall
+	j	$31
+	.end TraceDump
+
+	.globl ShmCreate
+	.ent	ShmCreate
+ShmCreate:
+	addiu $2,$0,SC_ShmCreate
+	syscall
+	j	$31
+	.end ShmCreate
+
+	.globl ShmAttach
+	.ent	ShmAttach
+ShmAttach:
+	addiu $2,$0,SC_ShmAttach
+	syscall
+	j	$31
+	.end ShmAttach
+
+	.globl ShmDetach
+	.ent	ShmDetach
+ShmDetach:
+	addiu $2,$0,SC_ShmDetach
+	syscall
+	j	$31
+	.end ShmDetach
+
+	.globl Sleep
+	.ent	Sleep
+Sleep:
+	addiu $2,$0,SC_Sleep
+	syscall
+	j	$31
+	.end Sleep
+
+	.globl SetWeight
+	.ent	SetWeight
+SetWeight:
+	addiu $2,$0,SC_SetWeight
+	syscall
+	j	$31
+	.end SetWeight
+
+	.globl FutexWait
+	.ent	FutexWait
+FutexWait:
+	addiu $2,$0,SC_FutexWait
+	syscall
+	j	$31
+	.end FutexWait
+
+	.globl FutexWake
+	.ent	FutexWake
+FutexWake:
+	addiu $2,$0,SC_FutexWake
+	syscall
+	j	$31
+	.end FutexWake
+
+/* -------------------------------------------------------------
+ * CompareAndSwap
+ *	Not a system call: "value" (r6) goes into the word at "addr" (r4)
+ *	if it holds "old" (r5), using LL and SC, and the old contents are
+ *	returned.  SC fails, and we try again, if anything else ran
+ *	since the LL.  The assembler may not know ll and sc for this
+ *	target, so they are written out: ll $2,0($4) and sc $3,0($4).
+ * -------------------------------------------------------------
+ */
+
+	.globl CompareAndSwap
+	.ent	CompareAndSwap
+CompareAndSwap:
+	.set	noreorder
+1:	.word	0xc0820000	/* ll	$2,0($4) */
+	nop
+	bne	$2,$5,2f
+	move	$3,$6
+	.word	0xe0830000	/* sc	$3,0($4) */
+	beq	$3,$0,1b
+	nop
+2:	j	$31
+	nop
+	.set	reorder
+	.end CompareAndSwap
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
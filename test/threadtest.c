@@ -0,0 +1,59 @@
+/* threadtest.c
+ *
+ * Simple test of Fork and Yield: two threads in this program's address
+ * space fill in halves of a shared array, yielding to each other as
+ * they go, while the first thread waits for both and adds it all up.
+ */
+
+#include "syscall.h"
+
+#define N	100
+
+int table[N];
+volatile int lowerDone = 0, upperDone = 0;	/* one each, so no update is lost */
+
+void
+lower()
+{
+  int i;
+
+  for (i = 0; i < N / 2; i++) {
+    table[i] = i;
+    if (i % 10 == 0)
+      Yield();
+  }
+  lowerDone = 1;
+}
+
+void
+upper()
+{
+  int i;
+
+  for (i = N / 2; i < N; i++) {
+    table[i] = i;
+    if (i % 10 == 0)
+      Yield();
+  }
+  upperDone = 1;
+}
+
+int
+main()
+{
+  int i, sum = 0;
+
+  Fork(lower);
+  Fork(upper);
+  while (!lowerDone || !upperDone)
+    Yield();
+
+  for (i = 0; i < N; i++)
+    sum += table[i];
+  if (sum == N * (N - 1) / 2)
+    Write("threads ok\n", 11, ConsoleOutput);
+  else
+    Write("threads FAILED\n", 15, ConsoleOutput);
+  Exit(sum);
+  /* not reached */
+}
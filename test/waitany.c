@@ -0,0 +1,76 @@
+/* waitany.c
+ *
+ * Starts several kids and collects them with WaitAny in whatever
+ * order they finish, then checks that there is nothing left to wait
+ * for and that a kid cannot be joined twice.
+ */
+
+#include "syscall.h"
+
+#define KIDS 5
+
+int
+main()
+{
+  SpaceId kids[KIDS], kid;
+  int i, status;
+  char *args[2];
+
+  args[0] = "argkid";
+  args[1] = (char *)0;
+
+  for (i = 0; i < KIDS; i++)
+    kids[i] = Exec("./test/argkid", args);
+
+  for (i = 0; i < KIDS; i++) {
+    kid = WaitAny(&status);
+    prints("PARENT reaped kid ", ConsoleOutput);
+    printd(kid, ConsoleOutput);
+    prints(" with value of ", ConsoleOutput);
+    printd(status, ConsoleOutput);
+    prints("\n", ConsoleOutput);
+  }
+
+  if (WaitAny(&status) != -1)
+    prints("PARENT: WaitAny with no kids should fail\n", ConsoleOutput);
+  if (Join(kids[0]) != -1)
+    prints("PARENT: a kid can only be joined once\n", ConsoleOutput);
+
+  Halt();
+  /* not reached */
+}
+
+/* Print a null-terminated string "s" on open file
+   descriptor "file". */
+
+prints(s,file)
+char *s;
+OpenFileId file;
+
+{
+  while (*s != '\0') {
+    Write(s,1,file);
+    s++;
+  }
+}
+
+/* Print an integer "n" on open file descriptor "file". */
+
+printd(n,file)
+int n;
+OpenFileId file;
+
+{
+
+  int i;
+  char c;
+
+  if (n < 0) {
+    Write("-",1,file);
+    n = -n;
+  }
+  if ((i = n/10) != 0)
+    printd(i,file);
+  c = (char) (n % 10) + '0';
+  Write(&c,1,file);
+}
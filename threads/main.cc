@@ -8,8 +8,9 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -j <stats file> -mlfq -fair
+//		-q <quantum>
+//		-s -tr <trace file> -x <nachos file> -c <consoleIn> <consoleOut>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
@@ -18,10 +19,17 @@
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -j dumps the statistics as JSON into a file ("-" for stdout) at halt
+//    -mlfq schedules with a multilevel feedback queue instead of by
+//	fixed priority (cf. scheduler.h)
+//    -fair schedules by virtual runtime, giving each process a share of
+//	the CPU proportional to its weight (cf. scheduler.h, SetWeight)
+//    -q sets the time slice of user programs, in ticks (default 100)
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -tr dumps the system call trace into a file at halt (see bin/tracedump)
 //    -x runs a user program
 //    -c tests the console
 //
@@ -27,14 +27,24 @@
 // 	Initialize the list of ready but not running threads to empty.
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
-{
 #ifdef CHANGED
-    readyList = new std::priority_queue<Thread*, std::vector<Thread*>, MyCmp>;
+Scheduler::Scheduler(SchedPolicy p, int q)
+{
+    policy = p;
+    boostEpoch = 0;
+    lastBoost = 0;
+    minVruntime = 0;
+    quantum = q;
+    preempt = FALSE;
+    timerArmed = FALSE;
+    timerGen = 0;
+}
 #else
+Scheduler::Scheduler()
+{
     readyList = new List;
-#endif
 } 
+#endif
 
 //----------------------------------------------------------------------
 // Scheduler::~Scheduler
@@ -43,7 +53,9 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 { 
+#ifndef CHANGED
     delete readyList; 
+#endif
 } 
 
 //----------------------------------------------------------------------
@@ -61,7 +73,25 @@ Scheduler::ReadyToRun (Thread *thread)
 
     thread->setStatus(READY);
 #ifdef CHANGED
-    readyList->push(thread);
+    if (policy == MLFQPolicy) {
+	CatchUp(thread);
+	readyList.Append(thread, thread->mlfqLevel);
+    } else if (policy == FairPolicy) {
+	if (thread == currentThread)	// yielding: its key must be final
+	    Charge(thread);		// before it goes in the tree
+	if (thread->vruntime + FairSleeperCredit < minVruntime)
+	    thread->vruntime = minVruntime - FairSleeperCredit;
+	fairTree.insert(thread);
+    } else {
+	int level = thread->getPriorityLevel();
+	if (level < 0)
+	    level = 0;
+	else if (level >= NumRunLevels)
+	    level = NumRunLevels - 1;
+	readyList.Append(thread, level);
+    }
+    if (preempt && !timerArmed && thread != currentThread)
+	ArmTimer(currentThread);	// it has company now
 #else
     readyList->Append((void *)thread);
 #endif
@@ -79,15 +109,19 @@ Thread *
 Scheduler::FindNextToRun ()
 {
 #ifdef CHANGED
-    Thread* thread;
-    if(readyList->empty())
-    	thread = NULL;
-    else
-    {
-    	thread = readyList->top();
-    	readyList->pop();
+    if (policy == FairPolicy) {
+	if (fairTree.empty())
+	    return NULL;
+	Thread *thread = *fairTree.begin();
+	fairTree.erase(fairTree.begin());
+	if (thread->vruntime > minVruntime)
+	    minVruntime = thread->vruntime;
+	return thread;
     }
-    return thread;
+    if (policy == MLFQPolicy && stats->totalTicks - lastBoost >= 
+	    (unsigned long long) MLFQBoostQuanta * quantum)
+	Boost();
+    return readyList.Remove();
 #else
     return (Thread *)readyList->Remove();
 #endif
@@ -112,15 +146,31 @@ Scheduler::Run (Thread *nextThread)
 {
     Thread *oldThread = currentThread;
     
-#ifdef USER_PROGRAM			// ignore until running user programs 
+#if defined(USER_PROGRAM) && !defined(CHANGED)  // ignore until running user programs 
     if (currentThread->space != NULL) {	// if this thread is a user program,
         currentThread->SaveUserState(); // save the user's CPU registers
 	currentThread->space->SaveState();
     }
 #endif
+    // Under CHANGED the user registers stay in the machine until some
+    // other user thread needs it; see Thread::LoadUserState.
     
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
+#ifdef CHANGED
+    if (policy == MLFQPolicy)		    // charge the old thread for
+	oldThread->sliceUsed += 	    // the time it just ran
+	    (int)(stats->totalTicks - oldThread->dispatchTicks);
+    else if (policy == FairPolicy)
+	Charge(oldThread);
+    nextThread->dispatchTicks = stats->totalTicks;
+    if (preempt)
+	ArmTimer(nextThread);
+#ifdef USER_PROGRAM
+    machine->linked = FALSE;		    // so an SC after the switch
+					    // fails (see OP_LL, mipssim.cc)
+#endif
+#endif
 
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
@@ -150,7 +200,11 @@ Scheduler::Run (Thread *nextThread)
     
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {		// if there is an address space
+#ifdef CHANGED
+        currentThread->LoadUserState();		// unless still loaded
+#else
         currentThread->RestoreUserState();     // to restore, do it.
+#endif
 		currentThread->space->RestoreState();
     }
 #endif
@@ -166,17 +220,396 @@ Scheduler::Print()
 {
     printf("Ready list contents:\n");
 #ifdef CHANGED
-    std::vector<Thread*> temp(readyList->size());
-    std::copy(&(readyList->top()), &(readyList->top()) + readyList->size(), &temp[0]);//copy priority queue to a vector
-    
-    
-    for(int i = 0; i < temp.size(); ++i)//this cannot guarantee print elements in priority queue order 
-    {
-    	Thread* t = temp[i];
-    	DEBUG('l', (char *) "In Scheduler Print, about to invoke %x(%x)\n", ThreadPrint, t);
-    	ThreadPrint((int)t);
+    if (policy == FairPolicy) {
+	std::multiset<Thread*, VruntimeCmp>::iterator it;
+	for (it = fairTree.begin(); it != fairTree.end(); ++it)
+	    printf("%s (%llu), ", (*it)->getName(), (*it)->vruntime);
+	printf("\n");
+	return;
     }
+    readyList.Print();
 #else
     readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
 #endif
 }
+
+#ifdef CHANGED
+//----------------------------------------------------------------------
+// SliceTimer
+// 	Interrupt handler for the end of a time slice; "gen" tells the
+//	Scheduler which arming of the timer this is.
+//----------------------------------------------------------------------
+
+static void
+SliceTimer(int gen)
+{
+    scheduler->TimerExpired(gen);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::StartTimer
+// 	From now on, preempt threads that have used up their slice
+//	(see scheduler.h).  Until this is called threads only switch
+//	when they block or yield, as before.
+//----------------------------------------------------------------------
+
+void
+Scheduler::StartTimer()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (!preempt) {
+	preempt = TRUE;
+	currentThread->dispatchTicks = stats->totalTicks;
+	ArmTimer(currentThread);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::TimerExpired
+// 	The running thread's slice is over.  If another thread should
+//	have the CPU, arrange for the running one to Yield when the
+//	interrupt handler returns; otherwise let it go on, timing a new
+//	slice if anybody is waiting for one.
+//
+//	"gen" is the timerGen the interrupt was scheduled with; if the
+//	timer has been re-armed since, this one is stale.
+//----------------------------------------------------------------------
+
+void
+Scheduler::TimerExpired(int gen)
+{
+    if (gen != timerGen)
+	return;
+    timerArmed = FALSE;
+    if (interrupt->getStatus() == IdleMode)
+	return;			// nobody is running; the next Run re-arms
+
+    if (ShouldPreempt()) {
+	DEBUG('t', "Time slice of \"%s\" is over\n", currentThread->getName());
+	interrupt->YieldOnReturn();
+    } else
+	ArmTimer(currentThread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NoneReady
+// 	Return TRUE if no thread is waiting for the CPU.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::NoneReady()
+{
+    if (policy == FairPolicy)
+	return fairTree.empty();
+    return readyList.IsEmpty();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Slice
+// 	Return the length of "thread"'s time slice under this policy.
+//----------------------------------------------------------------------
+
+int
+Scheduler::Slice(Thread *thread)
+{
+    if (policy == MLFQPolicy)
+	return quantum << thread->mlfqLevel;
+    if (policy != FairPolicy)
+	return quantum;
+
+    int slice = quantum;
+#ifdef USER_PROGRAM
+    if (thread->space != NULL)
+	slice = (int)((long long)quantum * thread->space->weight / FairWeight);
+#endif
+    if (slice < 1)
+	slice = 1;
+    else if (slice > FairMaxSlice * quantum)
+	slice = FairMaxSlice * quantum;
+    return slice;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ArmTimer
+// 	Schedule the slice timer for the end of "thread"'s slice, which
+//	has just started or is already under way.  Don't bother if there
+//	is nobody to switch to; ReadyToRun arms it when there is.
+//
+//	Assumes interrupts are already disabled.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ArmTimer(Thread *thread)
+{
+    timerGen++;			// forget any earlier arming
+    timerArmed = FALSE;
+    if (NoneReady())
+	return;
+
+    int left = Slice(thread);
+    if (policy == MLFQPolicy) {	// the slice survives Yield and Sleep
+	CatchUp(thread);
+	left = Slice(thread) - thread->sliceUsed - 
+	    (int)(stats->totalTicks - thread->dispatchTicks);
+	if (left < 1)
+	    left = 1;
+    }
+    interrupt->Schedule(SliceTimer, timerGen, left, TimerInt);
+    timerArmed = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ShouldPreempt
+// 	The running thread has reached the end of its slice.  Return
+//	TRUE if it should give up the CPU: under the priority policy
+//	whenever anything else is ready; under MLFQ likewise, once it is
+//	demoted a level for using its whole quantum; under the
+//	fair-share policy when some ready thread is owed more time.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::ShouldPreempt()
+{
+    Thread *thread = currentThread;
+
+    if (policy == FairPolicy) {
+	Charge(thread);
+	return !fairTree.empty() && 
+	    (*fairTree.begin())->vruntime < thread->vruntime;
+    }
+    if (policy == MLFQPolicy) {
+	CatchUp(thread);
+	int used = thread->sliceUsed + 
+	    (int)(stats->totalTicks - thread->dispatchTicks);
+	if (used < Slice(thread))
+	    return FALSE;		// a boost gave it a fresh slice
+	if (thread->mlfqLevel < MLFQLevels - 1)
+	    thread->mlfqLevel++;
+	thread->sliceUsed = 0;
+	thread->dispatchTicks = stats->totalTicks;
+	DEBUG('t', "Thread \"%s\" used its quantum, now at level %d\n",
+	      thread->getName(), thread->mlfqLevel);
+    }
+    return !NoneReady();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Blocked
+// 	"thread" is about to sleep on a Semaphore or Lock.  Under MLFQ
+//	a thread that gives up the CPU before its quantum runs out is
+//	likely interactive, so move it up a level with a fresh slice.
+//
+//	Assumes interrupts are already disabled.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Blocked(Thread *thread)
+{
+    if (policy != MLFQPolicy)
+	return;
+
+    CatchUp(thread);
+    if (thread->mlfqLevel > 0)
+	thread->mlfqLevel--;
+    thread->sliceUsed = 0;
+    thread->dispatchTicks = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Reprioritize
+// 	"thread"'s priority level has changed, because a Lock lent it a
+//	waiter's priority or took it back.  If it is waiting for the CPU
+//	under the priority policy, move it to its new level.  The other
+//	policies don't go by priority level.
+//
+//	Assumes interrupts are already disabled.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Reprioritize(Thread *thread)
+{
+    if (policy != PriorityPolicy || thread->getStatus() != READY)
+	return;
+
+    readyList.Unlink(thread);
+    ReadyToRun(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Boost
+// 	Put every ready thread back on level 0.  Threads that are running
+//	or blocked now pick the boost up in CatchUp, the next time the
+//	scheduler looks at them.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Boost()
+{
+    boostEpoch++;
+    lastBoost = stats->totalTicks;
+    DEBUG('t', "Priority boost %d\n", boostEpoch);
+
+    for (int i = 1; i < MLFQLevels; i++)
+	readyList.Splice(i, 0);
+    // the threads that were on level 0 already keep their place
+}
+
+//----------------------------------------------------------------------
+// Scheduler::CatchUp
+// 	If a boost happened since the scheduler last saw "thread", reset
+//	it to level 0 with a fresh slice.
+//----------------------------------------------------------------------
+
+void
+Scheduler::CatchUp(Thread *thread)
+{
+    if (thread->boostEpoch == boostEpoch)
+	return;
+    thread->boostEpoch = boostEpoch;
+    thread->mlfqLevel = 0;
+    thread->sliceUsed = 0;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Add the ticks "thread" has run since it was dispatched to its
+//	virtual runtime, scaled by its process's weight and thread count
+//	(see scheduler.h).  Kernel threads count as a process of their
+//	own with the ordinary weight.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Charge(Thread *thread)
+{
+    unsigned long long ran = stats->totalTicks - thread->dispatchTicks;
+    unsigned long long weight = FairWeight, threads = 1;
+
+#ifdef USER_PROGRAM
+    if (thread->space != NULL) {
+	weight = thread->space->weight;
+	threads = thread->space->num_threads();
+    }
+#endif
+    thread->vruntime += ran * FairWeight * threads / weight;
+    thread->dispatchTicks = stats->totalTicks;
+}
+#endif
+
+#ifdef CHANGED
+//----------------------------------------------------------------------
+// RunQueue::RunQueue
+// 	Initialize every level to empty.
+//----------------------------------------------------------------------
+
+RunQueue::RunQueue()
+{
+    nonEmpty = 0;
+    for (int i = 0; i < NumRunLevels; i++)
+	first[i] = last[i] = NULL;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Append
+// 	Put "thread" at the end of the FIFO for "level".
+//----------------------------------------------------------------------
+
+void
+RunQueue::Append(Thread *thread, int level)
+{
+    ASSERT(level >= 0 && level < NumRunLevels);
+    thread->readyNext = NULL;
+    thread->readyPrev = last[level];
+    thread->readyLevel = level;
+    if (last[level] == NULL)
+	first[level] = thread;
+    else
+	last[level]->readyNext = thread;
+    last[level] = thread;
+    nonEmpty |= 1u << level;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Remove
+// 	Take the thread off the front of the highest level that has
+//	any.  Return NULL if the queue is empty.
+//----------------------------------------------------------------------
+
+Thread *
+RunQueue::Remove()
+{
+    if (nonEmpty == 0)
+	return NULL;
+
+    int level = __builtin_ctz(nonEmpty);	// lowest set bit
+    Thread *thread = first[level];
+    Unlink(thread);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Unlink
+// 	Take "thread" off the level it is queued on.
+//----------------------------------------------------------------------
+
+void
+RunQueue::Unlink(Thread *thread)
+{
+    int level = thread->readyLevel;
+
+    if (thread->readyPrev == NULL)
+	first[level] = thread->readyNext;
+    else
+	thread->readyPrev->readyNext = thread->readyNext;
+    if (thread->readyNext == NULL)
+	last[level] = thread->readyPrev;
+    else
+	thread->readyNext->readyPrev = thread->readyPrev;
+    if (first[level] == NULL)
+	nonEmpty &= ~(1u << level);
+    thread->readyNext = thread->readyPrev = NULL;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Splice
+// 	Move the whole of level "from" onto the end of level "to",
+//	keeping their order.
+//----------------------------------------------------------------------
+
+void
+RunQueue::Splice(int from, int to)
+{
+    if (first[from] == NULL || from == to)
+	return;
+    for (Thread *t = first[from]; t != NULL; t = t->readyNext)
+	t->readyLevel = to;
+    first[from]->readyPrev = last[to];
+    if (last[to] == NULL)
+	first[to] = first[from];
+    else
+	last[to]->readyNext = first[from];
+    last[to] = last[from];
+    first[from] = last[from] = NULL;
+    nonEmpty &= ~(1u << from);
+    nonEmpty |= 1u << to;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Print
+// 	Print the non-empty levels, highest first.  For debugging.
+//----------------------------------------------------------------------
+
+void
+RunQueue::Print()
+{
+    for (int i = 0; i < NumRunLevels; i++) {
+	if (first[i] == NULL)
+	    continue;
+	printf("level %d: ", i);
+	for (Thread *t = first[i]; t != NULL; t = t->readyNext)
+	    ThreadPrint((int)t);
+	printf("\n");
+    }
+}
+#endif
@@ -14,26 +14,90 @@
 #include "thread.h"
 
 #ifdef CHANGED
-#include <queue>
+#include <set>
+#include "stats.h"
 
+// The ready threads, kept in one FIFO per priority level, 0 being the
+// highest.  The FIFOs are chained through Thread::readyNext and
+// readyPrev, so queueing
+// a thread never allocates, and bit i of "nonEmpty" is set while level
+// i has threads in it, so the best thread is found with one
+// find-first-set rather than a search.  Everything is constant time.
 
-// The following class defines the scheduler/dispatcher abstraction -- 
-// the data structures and operations needed to keep track of which 
-// thread is running, and which threads are ready but not running.
+#define NumRunLevels	32	// one per bit of nonEmpty
 
-class MyCmp//functor, for priority queue
-{
+class RunQueue {
   public:
-	bool operator()(Thread* t1, Thread* t2)
-	{
-		return t1->getPriorityLevel() > t2->getPriorityLevel(); //the smallest priority level would be at the front of queue
-	}
+    RunQueue();				// all levels empty
+
+    void Append(Thread* thread, int level); // put at the end of "level"
+    Thread* Remove();			// take the first thread off the
+					// highest non-empty level; NULL
+					// if there is none
+    void Unlink(Thread* thread);	// take "thread" off its level
+    void Splice(int from, int to);	// move all of "from" to the end
+					// of "to"
+    bool IsEmpty() { return nonEmpty == 0; }
+    void Print();			// print the threads, level by level
+
+  private:
+    unsigned int nonEmpty;		// bit per level with threads
+    Thread* first[NumRunLevels];
+    Thread* last[NumRunLevels];
+};
+
+// Which discipline the ready list follows; -mlfq picks the multilevel
+// feedback queue, -fair the fair-share scheduler, otherwise threads go
+// by their fixed priority level.
+enum SchedPolicy { PriorityPolicy, MLFQPolicy, FairPolicy };
+
+// Once StartTimer is called, a running thread is preempted when its
+// time slice runs out, if some other thread is ready by then.  The
+// slice depends on the policy: the quantum (-q) for PriorityPolicy,
+// the quantum doubled for each MLFQ level, and the quantum scaled by
+// the process's weight under FairPolicy.  While nothing else is ready
+// the timer is not armed at all.
+#define DefaultQuantum	TimerTicks	// ticks in a slice, unless -q
+
+// The multilevel feedback queue keeps a FIFO per level.  A thread that
+// runs out its quantum drops a level, where the quantum is twice as
+// long; a thread that blocks on a Semaphore or Lock moves up one.
+// Every MLFQBoostQuanta level 0 quanta everybody goes back to the top
+// level, so CPU hogs at the bottom are never starved for good.
+#define MLFQLevels	3	// number of run queues, 0 is the highest
+#define MLFQBoostQuanta	10	// quanta between priority boosts
+
+// The fair-share scheduler always runs the ready thread with the least
+// virtual runtime.  A thread's virtual runtime grows by the ticks it
+// runs, times FairWeight over its process's weight, times the number of
+// threads in its process: a process gets CPU in proportion to its
+// weight however many threads it has, and its threads split that.
+// A thread that slept is placed no further than FairSleeperCredit
+// behind the least virtual runtime, so it cannot bank time while away.
+#define FairWeight	1024	// weight of an ordinary process
+#define FairMaxWeight	(64 * FairWeight)
+#define FairSleeperCredit 20	// ticks of credit for having slept
+#define FairMaxSlice	8	// longest slice, in quanta
+
+class VruntimeCmp {		// orders the fair-share ready tree
+  public:
+    bool operator()(Thread* t1, Thread* t2) const
+	{ return t1->vruntime < t2->vruntime; }
 };
 #endif
 
+// The following class defines the scheduler/dispatcher abstraction -- 
+// the data structures and operations needed to keep track of which 
+// thread is running, and which threads are ready but not running.
+
 class Scheduler {
   public:
+#ifdef CHANGED
+    Scheduler(SchedPolicy p = PriorityPolicy, int q = DefaultQuantum);
+					// Initialize ready lists
+#else
     Scheduler();			// Initialize list of ready threads 
+#endif
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
@@ -41,10 +105,39 @@ class Scheduler {
 					// list, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
     void Print();			// Print contents of ready list
+#ifdef CHANGED
+    void StartTimer();			// Start preempting threads
+    void TimerExpired(int gen);		// Called from the slice timer's
+					// interrupt; internal
+    void Blocked(Thread* thread);	// thread is about to wait on a
+					// Semaphore or Lock
+    void Reprioritize(Thread* thread);	// its priority level changed
+#endif
     
   private:
 #ifdef CHANGED
-    std::priority_queue<Thread*, std::vector<Thread*>, MyCmp> *readyList; //for thread which has priority level
+    RunQueue readyList;			// by priority level, or by MLFQ
+					// level under MLFQPolicy
+    SchedPolicy policy;
+    int boostEpoch;			// number of boosts so far
+    unsigned long long lastBoost;	// stats->totalTicks at the last one
+    std::multiset<Thread*, VruntimeCmp> fairTree; // FairPolicy ready
+					// threads, least vruntime first
+    unsigned long long minVruntime;	// never decreases
+    int quantum;			// ticks in a level 0 slice
+    bool preempt;			// StartTimer has been called
+    bool timerArmed;			// a slice timer interrupt is due
+    int timerGen;			// bumped on every arming, so an
+					// interrupt left over from an
+					// earlier slice can be ignored
+
+    void Boost();			// move every thread to level 0
+    void CatchUp(Thread* thread);	// apply a boost it missed
+    void Charge(Thread* thread);	// add its run time to its vruntime
+    bool NoneReady();			// is the ready list empty?
+    int Slice(Thread* thread);		// its time slice, in ticks
+    void ArmTimer(Thread* thread);	// time the rest of its slice
+    bool ShouldPreempt();		// its slice ran out; switch?
 #else
     List *readyList;  		// queue of threads that are ready to run,
 				// but not running
@@ -37,7 +37,9 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
+#ifndef CHANGED
     queue = new List;
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -48,7 +50,9 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 
 Semaphore::~Semaphore()
 {
+#ifndef CHANGED
     delete queue;
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -67,7 +71,12 @@ Semaphore::P()
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
     
     while (value == 0) { 			// semaphore not available
+#ifdef CHANGED
+	queue.Append(currentThread);		// so go to sleep
+	scheduler->Blocked(currentThread);
+#else
 	queue->Append((void *)currentThread);	// so go to sleep
+#endif
 	currentThread->Sleep();
     } 
     value--; 					// semaphore available, 
@@ -90,7 +99,11 @@ Semaphore::V()
     Thread *thread;
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
+#ifdef CHANGED
+    thread = queue.Remove();
+#else
     thread = (Thread *)queue->Remove();
+#endif
     if (thread != NULL)	   // make thread ready, consuming the V immediately
 	scheduler->ReadyToRun(thread);
     value++;
@@ -105,14 +118,13 @@ Lock::Lock(char* debugName) {
 #ifdef CHANGED
     available = true;
     ownerThread = NULL;
-    queue = new List;
+    nextHeld = NULL;
 #endif
     
 }
 Lock::~Lock() {
 #ifdef CHANGED
 	ASSERT(ownerThread == NULL);//should release the lock before calling destructor
-	delete queue;
 #endif
 }
 void Lock::Acquire() {
@@ -123,11 +135,19 @@ void Lock::Acquire() {
 	
 	while(!available)//lock has been occupyied
 	{
-		queue->Append((void *)currentThread);
+		queue.Append(currentThread);
+		currentThread->waitingOn = this;
+		Donate(currentThread);//so the owner is not stuck behind threads less urgent than us
+		scheduler->Blocked(currentThread);
 		currentThread->Sleep();
 	}
+	currentThread->waitingOn = NULL;
 	available = false;
 	ownerThread = currentThread;
+	nextHeld = currentThread->heldLocks;
+	currentThread->heldLocks = this;
+	if(!queue.IsEmpty())//the other waiters now lend their priority to us
+		TakeBack(currentThread);
 	
 	(void) interrupt->SetLevel(oldLevel);
 #endif
@@ -138,17 +158,107 @@ void Lock::Release() {
 	
 	ASSERT(!available || ownerThread == currentThread);//cannot release an available lock or call release twice
 	
-	Thread* thread = (Thread *)queue->Remove();
+	Lock** link = &currentThread->heldLocks;//stop holding it...
+	while(*link != NULL && *link != this)
+		link = &(*link)->nextHeld;
+	if(*link == this)
+		*link = nextHeld;
+	nextHeld = NULL;
+	
+	Thread* thread = NULL;//...hand it to the most urgent waiter...
+	for(Thread* t = queue.Front(); t != NULL; t = queue.Next(t))
+		if(thread == NULL || t->getPriorityLevel() < thread->getPriorityLevel())
+			thread = t;
 	if(thread != NULL)
+	{
+		queue.Unlink(thread);
 		scheduler->ReadyToRun(thread); 
+	}
 	available = true;
 	ownerThread = NULL;
+	TakeBack(currentThread);//...and give back what its waiters lent us
 	
 	(void) interrupt->SetLevel(oldLevel);
 #endif
 	
 }
 
+#ifdef CHANGED
+//----------------------------------------------------------------------
+// Lock::Donate
+//	"waiter" is about to block on this lock.  If the owner has a
+//	worse priority level, lend it the waiter's, and if the owner is
+//	itself blocked on a lock, go on to that lock's owner, and so on.
+//	MaxDonationDepth bounds the walk in case of a deadlock cycle.
+//
+//	Assumes interrupts are already disabled.
+//----------------------------------------------------------------------
+
+#define MaxDonationDepth 8
+
+void Lock::Donate(Thread* waiter)
+{
+	int level = waiter->getPriorityLevel();
+	Lock* lock = this;
+	
+	for(int depth = 0; lock != NULL && depth < MaxDonationDepth; depth++)
+	{
+		Thread* owner = lock->ownerThread;
+		if(owner == NULL || owner->getPriorityLevel() <= level)
+			break;//nothing to lend, here or further down
+		DEBUG('t', "Lock %s: %s lends level %d to %s\n", lock->name, waiter->getName(), level, owner->getName());
+		owner->donatedLevel = level;
+		scheduler->Reprioritize(owner);//re-sort the ready list
+		lock = owner->waitingOn;
+	}
+}
+
+//----------------------------------------------------------------------
+// Lock::BestWaiterLevel
+//	Return the best priority level of the threads waiting for the
+//	lock, or NoDonation if there are none.
+//----------------------------------------------------------------------
+
+int Lock::BestWaiterLevel()
+{
+	int best = NoDonation;
+	
+	for(Thread* t = queue.Front(); t != NULL; t = queue.Next(t))
+	{
+		int level = t->getPriorityLevel();
+		if(level < best)
+			best = level;
+	}
+	return best;
+}
+
+//----------------------------------------------------------------------
+// Lock::TakeBack
+//	"thread" has just acquired or released a lock, so what the
+//	waiters lend it has changed.  Recompute it from the locks it
+//	still holds.
+//
+//	Assumes interrupts are already disabled.
+//----------------------------------------------------------------------
+
+void Lock::TakeBack(Thread* thread)
+{
+	int best = NoDonation;
+	
+	for(Lock* lock = thread->heldLocks; lock != NULL; lock = lock->nextHeld)
+	{
+		int level = lock->BestWaiterLevel();
+		if(level < best)
+			best = level;
+	}
+	if(best != thread->donatedLevel)
+	{
+		thread->donatedLevel = best;
+		scheduler->Reprioritize(thread);
+	}
+}
+#endif
+
 bool Lock::isHeldByCurrentThread()
 {
 #ifdef CHANGED
@@ -158,14 +268,8 @@ bool Lock::isHeldByCurrentThread()
 
 Condition::Condition(char* debugName) {
 	name = debugName;
-#ifdef CHANGED
-	queue = new List;
-#endif
 }
 Condition::~Condition() {
-#ifdef CHANGED
-	delete queue;
-#endif
 }
 void Condition::Wait(Lock* conditionLock) {
 #ifdef CHANGED
@@ -173,7 +277,7 @@ void Condition::Wait(Lock* conditionLock) {
 	ASSERT(conditionLock->isHeldByCurrentThread()); //a lock should have been acquired by current thread before Wait
 	
 	conditionLock->Release();//release this lock, the thread would go to sleep
-	queue->Append((void *)currentThread);
+	queue.Append(currentThread);
 	currentThread->Sleep();
 	conditionLock->Acquire();//after thread wake up, contonue to have this lock, Mesa-style
 	
@@ -186,7 +290,7 @@ void Condition::Signal(Lock* conditionLock) {
 	
 	ASSERT(conditionLock->isHeldByCurrentThread()); //a lock should have been acquired by current thread before Wait
 	
-	Thread* thread = (Thread *)queue->Remove();
+	Thread* thread = queue.Remove();
 	if(thread != NULL)
 		scheduler->ReadyToRun(thread);
 	
@@ -198,13 +302,166 @@ void Condition::Broadcast(Lock* conditionLock) {
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
 	ASSERT(conditionLock->isHeldByCurrentThread()); //a lock should have been acquired by current thread before Wait
 	
-	while(!queue->IsEmpty())
-	{
-		Thread* thread = (Thread *)queue->Remove();
-		if(thread != NULL)
-			scheduler->ReadyToRun(thread);
-	}
+	Thread* thread;
+	while((thread = queue.Remove()) != NULL)
+		scheduler->ReadyToRun(thread);
 	
 	(void) interrupt->SetLevel(oldLevel);
 #endif
 }
+
+#ifdef CHANGED
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader-writer lock, held by nobody.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char* debugName)
+{
+    name = debugName;
+    readers = 0;
+    writer = NULL;
+    upgrader = NULL;
+    waitingWriters = 0;
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+// 	De-allocate the lock, which nobody may be holding.
+//----------------------------------------------------------------------
+
+RWLock::~RWLock()
+{
+    ASSERT(readers == 0 && writer == NULL);
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireRead
+// 	Wait until neither a writer holds the lock nor one is waiting
+//	for it, then share it with the other readers.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireRead()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(writer != currentThread);
+    while (writer != NULL || waitingWriters > 0 || upgrader != NULL) {
+	readQueue.Append(currentThread);
+	scheduler->Blocked(currentThread);
+	currentThread->Sleep();
+    }
+    readers++;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseRead
+// 	Give up a read hold.  The last reader out lets a writer in, or
+//	an upgrading reader once it is the only one left.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseRead()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(readers > 0 && writer == NULL && upgrader != currentThread);
+    readers--;
+    if (upgrader != NULL) {
+	if (readers == 1)
+	    scheduler->ReadyToRun(upgrader);
+    } else if (readers == 0) {
+	Thread *thread = writeQueue.Remove();
+	if (thread != NULL)
+	    scheduler->ReadyToRun(thread);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireWrite
+// 	Wait until nobody holds the lock, then hold it alone.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireWrite()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(writer != currentThread);
+    waitingWriters++;
+    while (writer != NULL || readers > 0) {
+	writeQueue.Append(currentThread);
+	scheduler->Blocked(currentThread);
+	currentThread->Sleep();
+    }
+    waitingWriters--;
+    writer = currentThread;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseWrite
+// 	Give up the write hold.  Another writer goes next if one is
+//	waiting; otherwise all the waiting readers are let in.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseWrite()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *thread;
+
+    ASSERT(writer == currentThread);
+    writer = NULL;
+    if ((thread = writeQueue.Remove()) != NULL)
+	scheduler->ReadyToRun(thread);
+    else
+	while ((thread = readQueue.Remove()) != NULL)
+	    scheduler->ReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::Upgrade
+// 	Turn the current thread's read hold into a write hold, waiting
+//	for the other readers to leave; new readers and writers wait
+//	meanwhile.  Return FALSE, without waiting, if another reader is
+//	already upgrading -- both waiting would deadlock.
+//----------------------------------------------------------------------
+
+bool
+RWLock::Upgrade()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(readers > 0 && writer == NULL);
+    if (upgrader != NULL) {
+	(void) interrupt->SetLevel(oldLevel);
+	return FALSE;
+    }
+    upgrader = currentThread;
+    while (readers > 1)
+	currentThread->Sleep();		// the last other reader wakes us
+    upgrader = NULL;
+    readers--;
+    writer = currentThread;
+    (void) interrupt->SetLevel(oldLevel);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RWLock::isHeldByCurrentThread
+// 	Return TRUE if the current thread holds the lock for writing.
+//----------------------------------------------------------------------
+
+bool
+RWLock::isHeldByCurrentThread()
+{
+    return writer == currentThread;
+}
+#endif
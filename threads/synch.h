@@ -20,6 +20,9 @@
 #include "copyright.h"
 #include "thread.h"
 #include "list.h"
+#ifdef CHANGED
+#include "waitqueue.h"
+#endif
 
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
@@ -48,7 +51,11 @@ class Semaphore {
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
+#ifdef CHANGED
+    WaitQueue<Thread> queue; // threads waiting in P() for the value to be > 0
+#else
     List *queue;       // threads waiting in P() for the value to be > 0
+#endif
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -83,7 +90,12 @@ class Lock {
 #ifdef CHANGED
     bool available; //indicate whether this lock is available
     Thread* ownerThread;//thread which owns this thread
-    List* queue; //queue which stores the thread waiting for this lock
+    WaitQueue<Thread> queue; //queue which stores the thread waiting for this lock
+    Lock* nextHeld; //next lock held by ownerThread
+
+    void Donate(Thread* waiter); //lend waiter's priority down the chain of owners
+    int BestWaiterLevel(); //best priority level among the waiters
+    static void TakeBack(Thread* thread); //recompute what thread is lent
 #endif
 };
 
@@ -138,7 +150,55 @@ class Condition {
     char* name;
     // plus some other stuff you'll need to define
 #ifdef CHANGED
-    List* queue;
+    WaitQueue<Thread> queue; //threads waiting for a Signal
 #endif
 };
+
+#ifdef CHANGED
+// The following class defines a "reader-writer lock", for structures
+// that are read much more often than they are changed.  Any number of
+// threads may hold it for reading at once, or a single thread for
+// writing:
+//
+//	AcquireRead/ReleaseRead -- share the lock with other readers
+//
+//	AcquireWrite/ReleaseWrite -- hold the lock alone
+//
+//	Upgrade -- turn a read hold into a write hold, without letting
+//		another writer in between.  Only one reader can be
+//		upgrading at a time; if another already is, Upgrade
+//		returns FALSE, still holding the lock for reading, and
+//		the caller must release it and call AcquireWrite.
+//
+// Writers are preferred: once a writer is waiting, new readers wait
+// behind it, so a stream of readers cannot starve writers.  Neither
+// kind of hold may be taken again by the thread that has it.
+
+class RWLock {
+  public:
+    RWLock(char* debugName);		// initialize to FREE
+    ~RWLock();				// deallocate the lock
+    char* getName() { return name; }	// debugging assist
+
+    void AcquireRead();
+    void ReleaseRead();
+    void AcquireWrite();
+    void ReleaseWrite();
+    bool Upgrade();			// FALSE if somebody beat us to it
+
+    bool isHeldByCurrentThread();	// true if the current thread 
+					// holds it for writing
+    bool isReadHeld() { return readers > 0; } // true if some thread
+					// holds it for reading
+
+  private:
+    char* name;				// for debugging
+    int readers;			// threads holding it for reading
+    Thread* writer;			// thread holding it for writing
+    Thread* upgrader;			// reader waiting in Upgrade
+    int waitingWriters;			// threads waiting in AcquireWrite
+    WaitQueue<Thread> readQueue;	// threads waiting to read
+    WaitQueue<Thread> writeQueue;	// threads waiting to write
+};
+#endif
 #endif // SYNCH_H
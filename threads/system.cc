@@ -8,6 +8,17 @@
 #include "copyright.h"
 #include "system.h"
 #include "fd_list.h"
+#ifdef USER_PROGRAM
+#include "syscalltable.h"
+#include "synchconsole.h"
+#include "aio.h"
+#include "execcache.h"
+#include "proctable.h"
+#include "filetable.h"
+#include "systrace.h"
+#include "shm.h"
+#include "futex.h"
+#endif
 
 // This defines *all* of the global data structures used by Nachos.
 // These are all initialized and de-allocated by this file.
@@ -30,6 +41,14 @@ FileSystem  *fileSystem;
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+SynchConsole *synchConsole;	// console for the Read/Write syscalls
+AioManager *aioManager;		// for the AioRead/AioWrite syscalls
+ExecCache *execCache;		// for Exec
+ProcessTable *processTable;	// for Exec, Exit, Join and WaitAny
+FileTable *fileTable;		// for Open, Close, Dup and Pipe
+SyscallTrace *syscallTrace;	// for every system call
+ShmManager *shmManager;		// for ShmCreate, ShmAttach and ShmDetach
+FutexTable *futexTable;		// for FutexWait and FutexWake
 #endif
 
 #ifdef NETWORK
@@ -80,10 +99,14 @@ Initialize(int argc, char **argv)
 {
     int argCount;
     char* debugArgs = "";
+    char* statsFile = NULL;
     bool randomYield = FALSE;
+    SchedPolicy policy = PriorityPolicy;
+    int quantum = DefaultQuantum;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    char* traceFile = NULL;	// dump the system call trace at halt
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -108,10 +131,28 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-j")) {
+	    ASSERT(argc > 1);
+	    statsFile = *(argv + 1);		// dump statistics as JSON
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-mlfq")) {
+	    policy = MLFQPolicy;		// multilevel feedback queue
+	} else if (!strcmp(*argv, "-fair")) {
+	    policy = FairPolicy;		// fair share by virtual runtime
+	} else if (!strcmp(*argv, "-q")) {
+	    ASSERT(argc > 1);
+	    quantum = atoi(*(argv + 1));	// ticks in a time slice
+	    ASSERT(quantum > 0);
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-tr")) {
+	    ASSERT(argc > 1);
+	    traceFile = *(argv + 1);
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -132,8 +173,9 @@ Initialize(int argc, char **argv)
 
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
+    stats->jsonFile = statsFile;
     interrupt = new Interrupt;			// start up interrupt handling
-    scheduler = new Scheduler();		// initialize the ready queue
+    scheduler = new Scheduler(policy, quantum);	// initialize the ready queue
     if (randomYield)				// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
@@ -150,15 +192,19 @@ Initialize(int argc, char **argv)
     
 #ifdef USER_PROGRAM
     machine = new Machine(debugUserProg);	// this must come first
-	/* added stuff for userprog 
-	process_table[2048] = {0};
-	Lock *process_table_lock = new Lock("proc table lock");
-	total_process = active_process = 1;
-*/	
+    RegisterSyscalls();
+    synchConsole = new SynchConsole(NULL, NULL, FALSE);	// output only
+    aioManager = new AioManager;
+    execCache = new ExecCache;
+    processTable = new ProcessTable;
+    fileTable = new FileTable;
+    syscallTrace = new SyscallTrace(traceFile);
+    shmManager = new ShmManager;
+    futexTable = new FutexTable;
 #endif
 
-#ifdef FILESYS
-    synchDisk = new SynchDisk("DISK");
+#if defined(FILESYS) || defined(USER_PROGRAM)
+    synchDisk = new SynchDisk("DISK");		// also the paging device
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -183,6 +229,15 @@ Cleanup()
 #endif
     
 #ifdef USER_PROGRAM
+    delete synchConsole;
+    // aioManager is left alone: its I/O thread may be blocked in it
+    delete execCache;
+    delete processTable;
+    delete fileTable;
+    syscallTrace->Halt();
+    delete syscallTrace;
+    delete shmManager;
+    delete futexTable;
     delete machine;
 #endif
 
@@ -190,7 +245,7 @@ Cleanup()
     delete fileSystem;
 #endif
 
-#ifdef FILESYS
+#if defined(FILESYS) || defined(USER_PROGRAM)
     delete synchDisk;
 #endif
     
@@ -36,20 +36,22 @@ extern Machine* machine;	// user program memory and registers
 
 #include "addrspace.h"
 #include "synch.h"
-/* struct to hold information relevant to an executing process that the OS may need to know */
-typedef struct
-{
-	AddrSpace *myspace;
-	int totthreads;
-	int alivethreads;
-	int pid;
-	int stack[2048];
-} proc_table_t;
-
-extern proc_table_t process_table[2048]; // hold some info on processes in the OS
-extern int total_process; // global OS counter
-extern Lock *proc_table_lock; // lock for proc table
-extern int active_process;
+class SynchConsole;
+extern SynchConsole *synchConsole;	// the console used by user programs
+class AioManager;
+extern AioManager *aioManager;		// asynchronous file I/O
+class ExecCache;
+extern ExecCache *execCache;		// recently run executables
+class ProcessTable;
+extern ProcessTable *processTable;	// pids, exit status, Join
+class FileTable;
+extern FileTable *fileTable;		// files open in any process
+class SyscallTrace;
+extern SyscallTrace *syscallTrace;	// the last system calls made
+class ShmManager;
+extern ShmManager *shmManager;		// shared memory segments
+class FutexTable;
+extern FutexTable *futexTable;		// threads waiting on user words
 
 #endif
 
@@ -9,6 +9,8 @@
 //	Sleep -- relinquish control over the CPU, but thread is now blocked.
 //		In other words, it will not run again, until explicitly 
 //		put back on the ready queue.
+//	SleepFor -- block, and be put back on the ready queue by an
+//		alarm after a given amount of simulated time.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -19,11 +21,112 @@
 #include "switch.h"
 #include "synch.h"
 #include "system.h"
+#ifdef USER_PROGRAM
+#include "aio.h"
+#include "proctable.h"
+#endif
 
 #define STACK_FENCEPOST 0xdeadbeef	// this is put at the top of the
 					// execution stack, for detecting 
 					// stack overflows
 
+#ifdef CHANGED
+static void *threadPool[ThreadPoolSize];	// free Thread blocks
+static int pooledThreads = 0;
+static int *stackPool[StackPoolSize];		// free thread stacks
+static int pooledStacks = 0;
+#ifdef USER_PROGRAM
+static Thread *registerOwner = NULL;	// whose user registers the 
+					// machine holds, if anybody's
+#endif
+
+//----------------------------------------------------------------------
+// Thread::operator new
+// 	Allocate the memory for a Thread, reusing the block of one that
+//	was deleted if there is one.  Interrupts are turned off while
+//	the pool is touched, since threads are deleted with them off,
+//	from Scheduler::Run.
+//----------------------------------------------------------------------
+
+void *
+Thread::operator new(size_t size)
+{
+    ASSERT(size == sizeof(Thread));
+    IntStatus oldLevel = (interrupt != NULL) ? 
+	interrupt->SetLevel(IntOff) : IntOff;
+    void *block = (pooledThreads > 0) ? threadPool[--pooledThreads] : NULL;
+    if (interrupt != NULL)
+	(void) interrupt->SetLevel(oldLevel);
+
+    if (block == NULL)
+	block = ::operator new(size);
+    return block;
+}
+
+//----------------------------------------------------------------------
+// Thread::operator delete
+// 	Keep the memory of a deleted Thread for the next one, unless
+//	the pool is full.
+//----------------------------------------------------------------------
+
+void
+Thread::operator delete(void *block)
+{
+    if (block == NULL)
+	return;
+    IntStatus oldLevel = (interrupt != NULL) ? 
+	interrupt->SetLevel(IntOff) : IntOff;
+    if (pooledThreads < ThreadPoolSize) {
+	threadPool[pooledThreads++] = block;
+	block = NULL;
+    }
+    if (interrupt != NULL)
+	(void) interrupt->SetLevel(oldLevel);
+
+    if (block != NULL)
+	::operator delete(block);
+}
+
+//----------------------------------------------------------------------
+// AllocStack
+// 	Return a thread execution stack of StackSize words, a recycled
+//	one if there is one.  The guard pages AllocBoundedArray put
+//	around it are left as they are while it sits in the pool.
+//----------------------------------------------------------------------
+
+static int *
+AllocStack()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int *stack = (pooledStacks > 0) ? stackPool[--pooledStacks] : NULL;
+    (void) interrupt->SetLevel(oldLevel);
+
+    if (stack == NULL)
+	stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    return stack;
+}
+
+//----------------------------------------------------------------------
+// FreeStack
+// 	Put a stack back in the pool, or give it back to the host if the
+//	pool is full.
+//----------------------------------------------------------------------
+
+static void
+FreeStack(int *stack)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    if (pooledStacks < StackPoolSize) {
+	stackPool[pooledStacks++] = stack;
+	stack = NULL;
+    }
+    (void) interrupt->SetLevel(oldLevel);
+
+    if (stack != NULL)
+	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+}
+#endif
+
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
@@ -38,8 +141,21 @@ Thread::Thread(char* threadName)
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
+#ifdef CHANGED
+    priorityLevel = 1;
+    mlfqLevel = sliceUsed = dispatchTicks = boostEpoch = 0;
+    readyNext = readyPrev = NULL;
+    readyLevel = 0;
+    donatedLevel = NoDonation;
+    waitingOn = heldLocks = NULL;
+    waitNext = waitPrev = NULL;
+    vruntime = 0;
+#endif
 #ifdef USER_PROGRAM
     space = NULL;
+    pid = -1;
+    stackPage = -1;
+    exitStatus = 0;
 #endif
 }
 #ifdef CHANGED
@@ -47,6 +163,13 @@ Thread::Thread(char* debugName, int priority)
 {
 	name = debugName;
 	priorityLevel = priority;
+	mlfqLevel = sliceUsed = dispatchTicks = boostEpoch = 0;
+	readyNext = readyPrev = NULL;
+	readyLevel = 0;
+	donatedLevel = NoDonation;
+	waitingOn = heldLocks = NULL;
+	waitNext = waitPrev = NULL;
+	vruntime = 0;
 }
 #endif
 
@@ -70,33 +193,22 @@ Thread::~Thread()
 {
     DEBUG('t', "Deleting thread \"%s\"\n", name);
     ASSERT(this != currentThread);
+#if defined(CHANGED) && defined(USER_PROGRAM)
+    if (registerOwner == this)		// its registers need no saving
+	registerOwner = NULL;
+#endif
     if (stack != NULL)
+#ifdef CHANGED
+	FreeStack(stack);
+#else
 	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+#endif
 	
 #ifdef USER_PROGRAM
-	if(space != NULL)
+	//threads started by Fork share the space; the last one deletes it
+	if(space != NULL && space->num_threads() == 0)
 		delete space;
-	if(child == NULL)
-		return;
-	ChildThread* record = child;
-	while(record != child)
-	{
-		record = record->next;
-		record->prev->thread->parentRecord = NULL; //clear its child's record
-		delete record->prev;
-	}
-	child = NULL;
-	//parentRecord has been handled in notifyParent
-	//Only when deleleting the parent, the parentRecord(this parent's child) would be deleted
-	/*if(parentRecord != NULL) //deal with its parent's record
-	{
-		ASSERT(parentRecord->thread == this);
-		if(returnStatus = -1)
-			returnStatus = 0;
-		parentRecord->thread = NULL; //parent record would not have this child anymore
-		parentRecord->status = returnStatus;
-		parentRecord->join_sem->V(); //if parent is waiting on a join(), release them;
-	}*/
+	//the process record is looked after by the process table
 #endif
 }
 
@@ -174,12 +286,35 @@ Thread::CheckOverflow()
 //
 // 	NOTE: we disable interrupts, so that we don't get a time slice 
 //	between setting threadToBeDestroyed, and going to sleep.
+//
+//	A user thread gives back the stack Fork carved for it.  The last
+//	thread of a user program first waits out any asynchronous I/O 
+//	still running against its memory, since that goes away with the
+//	thread, and closes its files and pipes; then it records the exit
+//	status, its own, for the process.
 //----------------------------------------------------------------------
 
 //
 void
 Thread::Finish ()
 {
+#ifdef USER_PROGRAM
+    if (space != NULL) {
+	int left = (stackPage >= 0) ? 
+		space->free_stack(stackPage, ThreadStackPages) :
+		space->remove_thread();
+
+	// The count drops with interrupts off, so exactly one thread
+	// of the space sees it reach 0, and only that one exits the
+	// process.
+	if (left == 0) {
+	    aioManager->Release(space);
+	    space->close_files();	// so pipe readers see end of file
+	    DEBUG('t', "Process %d exits with %d\n", pid, exitStatus);
+	    processTable->Exit(pid, exitStatus);
+	}
+    }
+#endif
     (void) interrupt->SetLevel(IntOff);		
     ASSERT(this == currentThread);
     
@@ -261,10 +396,56 @@ Thread::Sleep ()
     //printf("In sleep: nextThread: %s\n", nextThread->getName());    
     scheduler->Run(nextThread); // returns when we've been signalled
 }
+
+//----------------------------------------------------------------------
+// ThreadWakeup
+// 	Interrupt handler for the alarm set by SleepFor: put the sleeping
+//	thread back on the ready queue.
+//
+//	"arg" is the thread, cast to an int
+//----------------------------------------------------------------------
+
+static void
+ThreadWakeup(int arg)
+{
+    Thread *thread = (Thread *) arg;
+
+    DEBUG('t', "Waking up thread \"%s\"\n", thread->getName());
+    scheduler->ReadyToRun(thread);
+}
+
+//----------------------------------------------------------------------
+// Thread::SleepFor
+// 	Block the current thread for "ticks" of simulated time.  An alarm
+//	interrupt puts it back on the ready queue; until then it is not
+//	on it, so it costs the other threads nothing (unlike a loop of
+//	Yields).  If nothing else is runnable, the machine idles until
+//	the alarm goes off.
+//
+//	A "ticks" of 0 or less just yields.
+//----------------------------------------------------------------------
+
+void
+Thread::SleepFor(int ticks)
+{
+    ASSERT(this == currentThread);
+    if (ticks <= 0) {
+	Yield();
+	return;
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    DEBUG('t', "Thread \"%s\" sleeping for %d ticks\n", getName(), ticks);
+    interrupt->Schedule(ThreadWakeup, (int) this, ticks, AlarmInt);
+    Sleep();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
 #ifdef CHANGED
-int Thread::getPriorityLevel()//return the private member priorityLevel
+int Thread::getPriorityLevel()//return the private member priorityLevel, unless a waiter lent it a better one
 {
-	return priorityLevel;
+	return donatedLevel < priorityLevel ? donatedLevel : priorityLevel;
 }
 #endif
 
@@ -295,7 +476,11 @@ void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
 void
 Thread::StackAllocate (VoidFunctionPtr func, int arg)
 {
+#ifdef CHANGED
+    stack = AllocStack();
+#else
     stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+#endif
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
@@ -360,8 +545,38 @@ Thread::RestoreUserState()
     for (int i = 0; i < NumTotalRegs; i++)
 	machine->WriteRegister(i, userRegisters[i]);
 }
-static int globalID = 0;
 
+#ifdef CHANGED
+//----------------------------------------------------------------------
+// Thread::LoadUserState
+//	Make the machine's registers this thread's user registers.
+//	Rather than saving a user thread's registers every time it
+//	gives up the CPU, they are left in the machine until another
+//	user thread is about to run, and saved then; switching to a
+//	kernel thread and back to the same user thread copies nothing.
+//
+//	Anything that writes the machine's registers for a thread must
+//	call this first.
+//----------------------------------------------------------------------
+
+void
+Thread::LoadUserState()
+{
+    if (registerOwner == this)
+	return;
+    if (registerOwner != NULL)
+	registerOwner->SaveUserState();
+    RestoreUserState();
+    registerOwner = this;
+}
+#endif
+
+//----------------------------------------------------------------------
+// Thread::Thread
+//      Create the thread that will run a new user process, and enter
+//      the process in the process table as a child of "parent"'s
+//      process.  "parent" is NULL for a process nobody will Join.
+//----------------------------------------------------------------------
 Thread::Thread(char* threadName, Thread* parent)
 {
 	name = threadName;
@@ -369,79 +584,39 @@ Thread::Thread(char* threadName, Thread* parent)
     stack = NULL;
     status = JUST_CREATED;
     priorityLevel = 1;
+    mlfqLevel = sliceUsed = dispatchTicks = boostEpoch = 0;
+    readyNext = readyPrev = NULL;
+    readyLevel = 0;
+    donatedLevel = NoDonation;
+    waitingOn = heldLocks = NULL;
+    waitNext = waitPrev = NULL;
+    vruntime = 0;
     
     //USER_PROGRAM
-    returnStatus = -1;
     space = NULL;
-    parentRecord = NULL;
-    child = NULL;
-    nextID = 0;
+    stackPage = -1;
+    exitStatus = 0;
     
     for(int i = 0; i < NumTotalRegs; i++)
         userRegisters[i] = 0;
-	if(!parent)
-		return;
-	if(parent->child == NULL)
-	{
-		parentRecord = new ChildThread(this);
-		parent->child = parentRecord;
-		//parent->child->id = parent->nextID++;
-		parentRecord->id = globalID++;
-	}
-	else
-	{
-		ChildThread* firstChild = parent->child;
-		parentRecord = new ChildThread(this);
-		//parentRecord->id = parent->nextID++;
-		parentRecord->id = globalID++;
-		
-		parentRecord->prev = firstChild->prev;
-		parentRecord->next = firstChild;
-		firstChild->prev->next = parentRecord;
-		firstChild->prev = parentRecord;
-	}
+    pid = processTable->Add(this, parent != NULL ? parent->pid : -1);
 }
 
+//Note the status this thread exits with. A process with threads started
+//by Fork exits with its last thread, so Finish hands the status of
+//whichever thread turns out to be last to the process table; a thread
+//without a space is a process of its own.
 void Thread::notifyParent(int status)
 {
-	if(parentRecord != NULL)//this thread has parent
-	{
-		DEBUG('t', "Set record to %d\n", status);
-		parentRecord->status = status;
-		parentRecord->thread = NULL;
-		parentRecord->join_sem->V(); //signal
+	exitStatus = status;
+	if(space == NULL) {
+		DEBUG('t', "Process %d exits with %d\n", pid, status);
+		processTable->Exit(pid, status);
 	}
 }
 
 int Thread::getID() {
-    if(parentRecord != NULL) {
-        return parentRecord->id;
-    }
-    DEBUG('t', "Called getID on thread %p with no parent.\n", this);
-    return -1;
-}
-
-//----------------------------------------------------------------------
-// ChildThread::ChildThread
-//      Create an element in the linked list of children of this thread. The
-//      argument 'thread' is the new thread being inserted.
-//
-//      The linked list is doubly linked, and circular.
-//----------------------------------------------------------------------
-ChildThread::ChildThread(Thread* t) {
-    status = -1;
-    join_sem = new Semaphore("ChildThread", 0);
-    thread = t;
-
-    next = prev = this;
-}
-
-//----------------------------------------------------------------------
-// ChildThread::~ChildThread
-//      Remove this thread from the parent's record.
-//----------------------------------------------------------------------
-ChildThread::~ChildThread() {
-    delete join_sem;
+    return pid;
 }
 
 #endif
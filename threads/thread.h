@@ -44,23 +44,6 @@
 #include "machine.h"
 #include "addrspace.h"
 #include "list.h"
-
-class Thread;
-class Semaphore;
-class ChildThread 
-{
-public:
-    ChildThread(Thread* t);
-    ~ChildThread();
-
-    Thread* thread;
-    int status;
-    int id;
-    Semaphore* join_sem;
-    ChildThread* next;
-    ChildThread* prev;
-};
-
 #endif
 
 // CPU register state to be saved on context switch.  
@@ -73,6 +56,19 @@ public:
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 #define StackSize	(4 * 1024)	// in words
 
+#ifdef CHANGED
+// Finished threads leave their control block and stack behind for the
+// next thread to use, up to this many of each, so that creating a
+// thread does not usually cost a trip to the host's allocator (or
+// the guard pages around the stack being set up again).
+#define ThreadPoolSize	16
+#define StackPoolSize	16
+#endif
+
+
+#ifdef CHANGED
+class Lock;
+#endif
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
@@ -108,6 +104,10 @@ class Thread {
 					// NOTE -- thread being deleted
 					// must not be running when delete 
 					// is called
+#ifdef CHANGED
+    static void* operator new(size_t size);	// take a block from the
+    static void operator delete(void* block);	// pool, and put it back
+#endif
 
     // basic thread operations
 
@@ -116,15 +116,42 @@ class Thread {
 						// other thread is runnable
     void Sleep();  				// Put the thread to sleep and 
 						// relinquish the processor
+    void SleepFor(int ticks);			// Sleep until "ticks" of
+						// simulated time have passed
     void Finish();  				// The thread is done executing
     
     void CheckOverflow();   			// Check if thread has 
 						// overflowed its stack
     void setStatus(ThreadStatus st) { status = st; }
+#ifdef CHANGED
+    ThreadStatus getStatus() { return status; }
+#endif
     char* getName() { return (name); }
     void Print() { printf("%s, ", name); }
 #ifdef CHANGED
-    int getPriorityLevel();
+    int getPriorityLevel();		// its own level, or a better one
+					// lent by a thread waiting on a
+					// Lock it holds
+
+    // Priority inheritance (see synch.cc); only Lock touches these.
+    int donatedLevel;			// NoDonation, or the best level of
+					// the waiters on its Locks
+    Lock* waitingOn;			// Lock it is blocked on, or NULL
+    Lock* heldLocks;			// Locks it holds, through nextHeld
+    Thread* waitNext;			// neighbours on the WaitQueue of the
+    Thread* waitPrev;			// Semaphore, Lock or Condition it
+					// is blocked on
+
+    // Bookkeeping for the multilevel feedback queue (see scheduler.h);
+    // only the Scheduler touches these.
+    int mlfqLevel;			// run queue the thread belongs on
+    int sliceUsed;			// ticks run at this level so far
+    unsigned long long dispatchTicks;	// stats->totalTicks when switched in
+    int boostEpoch;			// Scheduler boost it has been through
+    Thread* readyNext;			// neighbours on the same RunQueue
+    Thread* readyPrev;			// level
+    int readyLevel;			// which level that is
+    unsigned long long vruntime;	// weighted ticks run (FairPolicy)
 #endif
   private:
     // some of the private data for this class is listed above
@@ -136,6 +163,7 @@ class Thread {
     char* name;
 #ifdef CHANGED
 	int priorityLevel; //0 is high priority, 1 is low priority
+#define NoDonation	0x7fffffff	// worse than any priority level
 #endif
     void StackAllocate(VoidFunctionPtr func, int arg);
     					// Allocate a stack for thread.
@@ -147,21 +175,27 @@ class Thread {
 // while executing kernel code.
 
     int userRegisters[NumTotalRegs];	// user-level CPU register state
-    
-    ChildThread* parentRecord; //for this thread's parent keep
 
   public:
     void SaveUserState();		// save user-level register state
     void RestoreUserState();		// restore user-level register state
+#ifdef CHANGED
+    void LoadUserState();		// make the machine's registers ours,
+					// saving whoever's are there
+#endif
+    void setUserRegister(int num, int value) { userRegisters[num] = value; }
+					// set up a thread before it runs
 	
     AddrSpace *space;			// User code this thread is running.
     
-    void notifyParent(int status);
-    int getID();
+    void notifyParent(int status);	// record the exit status
+    int getID();			// the process id
     
-    ChildThread* child;//this thread's child
-    int nextID;//next ID for its child
-    int returnStatus;
+    int pid;				// in the process table; -1 if none
+    int exitStatus;			// as passed to notifyParent
+    int stackPage;			// first page of the user stack carved
+					// for it by Fork; -1 for the thread
+					// that started the program
 #endif
 };
 
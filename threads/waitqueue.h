@@ -0,0 +1,103 @@
+// waitqueue.h
+//	Data structures for the queue of threads waiting on a
+//	synchronization object.
+//
+//	A WaitQueue is a FIFO threaded through "waitNext" and "waitPrev"
+//	pointers kept in the items themselves, rather than through
+//	ListElements allocated on every Append.  Since a thread waits on
+//	at most one Semaphore, Lock or Condition at a time, one pair of
+//	pointers in each Thread is enough.  Every operation is constant
+//	time and none allocates.
+//
+//	The queue is a template so that it is typed: T is any class with
+//	public "T *waitNext, *waitPrev" members.  Like the rest of the
+//	synchronization code, it assumes interrupts are disabled.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef WAITQUEUE_H
+#define WAITQUEUE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+template <class T>
+class WaitQueue {
+  public:
+    WaitQueue() { first = last = NULL; }	// initialize to empty
+
+    void Append(T* item);		// Put item at the end of the queue
+    T* Remove();			// Take item off the front of the
+					// queue; NULL if it is empty
+    void Unlink(T* item);		// Take item off, wherever it is
+
+    bool IsEmpty() { return first == NULL; }
+    T* Front() { return first; }	// for walking the queue, with
+    static T* Next(T* item) { return item->waitNext; }	// Next
+
+  private:
+    T* first;				// Head of the queue, NULL if empty
+    T* last;				// Last item of the queue
+};
+
+//----------------------------------------------------------------------
+// WaitQueue::Append
+//      Put "item" at the end of the queue.  It must not be on any
+//	other WaitQueue.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+WaitQueue<T>::Append(T* item)
+{
+    item->waitNext = NULL;
+    item->waitPrev = last;
+    if (last == NULL)
+	first = item;
+    else
+	last->waitNext = item;
+    last = item;
+}
+
+//----------------------------------------------------------------------
+// WaitQueue::Remove
+//      Take the item off the front of the queue.
+//
+// Returns:
+//	The item, or NULL if the queue is empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T*
+WaitQueue<T>::Remove()
+{
+    T* item = first;
+
+    if (item != NULL)
+	Unlink(item);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// WaitQueue::Unlink
+//      Take "item", which must be on this queue, off it.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+WaitQueue<T>::Unlink(T* item)
+{
+    if (item->waitPrev == NULL)
+	first = item->waitNext;
+    else
+	item->waitPrev->waitNext = item->waitNext;
+    if (item->waitNext == NULL)
+	last = item->waitPrev;
+    else
+	item->waitNext->waitPrev = item->waitPrev;
+    item->waitNext = item->waitPrev = NULL;
+}
+
+#endif // WAITQUEUE_H
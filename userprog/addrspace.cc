@@ -20,6 +20,8 @@
 #include "addrspace.h"
 #include "interrupt.h"
 #include "synch.h"
+#include "ring.h"
+#include "execcache.h"
 #include <map>
 #include <vector>
 
@@ -29,28 +31,22 @@
 
 // *** FD_List Class defs *** //
 /**
- * default constructor
+ * default constructor, no fds open
  */
-FD_List::FD_List( int i_size ) : map( i_size ), list( 0 ), lock( 0 ), size( i_size )
+FD_List::FD_List() : slots( 0 ), size( 0 ), lowest( 0 ), lock( 0 )
 {
-	list = new void*[ size ];
-	lock = new Lock("FD_List Lock");
-}
-
-FD_List::FD_List() : map( 512 ), list( 0 ), lock( 0 ), size( 512 )
-{
-	list = new void*[ size ];
 	lock = new Lock("FD_List Lock");
+	grow( InitialFDSlots );
 }
 
 /**
- * destructor
+ * destructor; the process closed its fds as it finished
  */
 FD_List::~FD_List()
 {
-	if( list )
+	if( slots )
 	{
-		delete list;
+		delete [] slots;
 	}
 	if( lock )
 	{
@@ -59,53 +55,201 @@ FD_List::~FD_List()
 }
 
 /**
- * Return a FD (if it exists) from the current FD list
+ * Make room for at least i_size slots, doubling so that a process
+ * opening many files copies its table only a few times.
+ * Returns FALSE past MaxFDSlots. Called with the lock held.
  */
-void* FD_List::fd_get( int i )
+bool FD_List::grow( int i_size )
 {
-	/* test if the fd is in range and in the map */
-	return (i >=0 && i < size && map.Test(i)) ? list[i] : 0;
+	int new_size = size > 0 ? size : InitialFDSlots;
+	OpenFileEntry **new_slots;
+	
+	if( i_size > MaxFDSlots ) return FALSE;
+	while( new_size < i_size ) new_size *= 2;
+	if( new_size > MaxFDSlots ) new_size = MaxFDSlots;
+	if( new_size <= size ) return TRUE;
+	
+	new_slots = new OpenFileEntry*[ new_size ];
+	for( int i = 0; i < new_size; i++ )
+	{
+		new_slots[ i ] = i < size ? slots[ i ] : 0;
+	}
+	if( slots )
+	{
+		delete [] slots;
+	}
+	slots = new_slots;
+	size = new_size;
+	return TRUE;
 }
 
 /**
- * Place an FD into the list (checks if the FD already exists in map)
+ * Put entry in the lowest free slot, starting from the hint. Every
+ * slot below the hint is taken, so the search only passes slots
+ * taken since the last one was freed. Returns -1 if none is left.
  */
-int FD_List::fd_put( void *new_fd )
+int FD_List::install( OpenFileEntry *entry )
 {
-	int i; // store the next index for FDs
+	int i;
 	
-	/* check the map for next index... */
 	lock->Acquire();
-	i = map.Find();
+	for( i = lowest; i < size && slots[ i ] != 0; i++ )
+		;
+	if( i == size && !grow( size + 1 ) )
+	{
+		lock->Release();
+		return -1;
+	}
+	slots[ i ] = entry;
+	lowest = i + 1;
 	lock->Release();
+	return i;
+}
+
+/**
+ * Return the open-file table entry of an FD (if it is open)
+ */
+OpenFileEntry* FD_List::fd_entry( int i )
+{
+	/* test if the fd is in range and open */
+	return (i >= 0 && i < size) ? slots[i] : 0;
+}
+
+/**
+ * Return the file or pipe an FD refers to (if it is open)
+ */
+void* FD_List::fd_get( int i )
+{
+	OpenFileEntry *entry = fd_entry( i );
+	return entry ? entry->object : 0;
+}
+
+/**
+ * Return what kind of object an FD refers to (FD_NONE if it isn't open)
+ */
+FDType FD_List::fd_type( int i )
+{
+	OpenFileEntry *entry = fd_entry( i );
+	return entry ? entry->type : FD_NONE;
+}
+
+/**
+ * Enter a newly opened object in the open-file table and give it the
+ * lowest free FD. If there is none, the object is closed again.
+ */
+int FD_List::fd_put( void *object, FDType type )
+{
+	OpenFileEntry *entry = fileTable->Open( type, object );
+	int i = install( entry );
 	
-	if( i != -1 )
-		list[ i ] = new_fd;
+	if( i == -1 )
+	{
+		fileTable->Release( entry );
+	}
 	return i;
 }
 
 /**
- * Remove a FD from the list
+ * Give the entry of FD i a second FD, the lowest free one, as Dup does.
+ * Both then share the file and its position.
+ */
+int FD_List::fd_dup( int i )
+{
+	OpenFileEntry *entry = fd_entry( i );
+	int new_fd;
+	
+	if( entry == 0 ) return -1;
+	
+	fileTable->Hold( entry );
+	new_fd = install( entry );
+	if( new_fd == -1 )
+	{
+		fileTable->Release( entry );
+	}
+	return new_fd;
+}
+
+/**
+ * Make FD i refer to entry too, as when it is inherited across Exec;
+ * fails if i is taken
+ */
+bool FD_List::fd_put_at( int i, OpenFileEntry *entry )
+{
+	if( i < 0 ) return FALSE;
+	
+	lock->Acquire();
+	if( ( i >= size && !grow( i + 1 ) ) || slots[ i ] != 0 )
+	{
+		lock->Release();
+		return FALSE;
+	}
+	fileTable->Hold( entry );
+	slots[ i ] = entry;
+	if( i == lowest ) lowest++;
+	lock->Release();
+	return TRUE;
+}
+
+/**
+ * Remove a FD from the list, returning its entry for the caller
+ * to release
  */
-void* FD_List::fd_remove( int i )
+OpenFileEntry* FD_List::fd_remove( int i )
 {
-	void *old_fd; // store the fd to remove for return
+	OpenFileEntry *old_entry = 0; // store the entry to remove for return
 	
 	if( i >= 0 && i < size )
 	{
 		lock->Acquire();
-		if( map.Test( i ) )
+		old_entry = slots[ i ];
+		slots[ i ] = 0;
+		if( old_entry && i < lowest )
 		{
-			map.Clear( i );
-			old_fd = list[ i ];
-			list[ i ] = 0;
+			lowest = i;
 		}
 		lock->Release();
 	}
-	return old_fd;
+	return old_entry;
 }
 // *** End FD_List *** //
 
+//Close fd, whatever it refers to. Returns FALSE if it wasn't open. The
+//file or pipe end itself is closed along with the last fd sharing it.
+bool AddrSpace::close_fd(int fd)
+{
+    OpenFileEntry* entry = open_files.fd_remove(fd);
+
+    if(entry == NULL) {
+        return FALSE;
+    }
+    fileTable->Release(entry);
+    return TRUE;
+}
+
+//Close every open fd, as the process finishes. A pipe's other end sees
+//end of file once the last writer is closed.
+void AddrSpace::close_files()
+{
+    for(int fd = 0; fd < open_files.fd_size(); fd++) {
+        close_fd(fd);
+    }
+}
+
+//Give this (new) address space the parent's fds, under the same numbers,
+//so a program can hand files, pipes and a redirected console to the
+//program it Execs. Both then share each entry, and a file's position.
+void AddrSpace::inherit_files(AddrSpace* parent)
+{
+    close_files();
+    for(int fd = 0; fd < parent->open_files.fd_size(); fd++) {
+        OpenFileEntry* entry = parent->open_files.fd_entry(fd);
+
+        if(entry != NULL) {
+            open_files.fd_put_at(fd, entry);
+        }
+    }
+}
+
 //----------------------------------------------------------------------
 // SwapHeader
 // 	Do little endian to big endian conversion on the bytes in the 
@@ -113,7 +257,7 @@ void* FD_List::fd_remove( int i )
 //	endian machine, and we're now running on a big endian machine.
 //----------------------------------------------------------------------
 
-static void 
+void 
 SwapHeader (NoffHeader *noffH)
 {
 	noffH->noffMagic = WordToHost(noffH->noffMagic);
@@ -128,6 +272,40 @@ SwapHeader (NoffHeader *noffH)
 	noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
 }
 
+//Frames in use: how many page table entries map each one. A frame shared
+//between address spaces (see shm.h) is counted once for each, and once for
+//its segment.
+static int available_pages[NumPhysPages] = {0};
+static BitMap available_sectors(NumSectors);
+
+//Return a free frame, counted once. If none is free, push one of space's
+//own pages to disk, waiting for that if need be.
+int AllocFrame(AddrSpace* space)
+{
+    for(int i = 0; i < NumPhysPages; i++) {
+        if(available_pages[i] == 0) {
+            DEBUG('u', "Found free page %d\n", i);
+            available_pages[i] = 1;
+            return i;
+        }
+    }
+    int frame = space->store_page();
+    available_pages[frame] = 1;
+    return frame;
+}
+
+void HoldFrame(int frame)
+{
+    ASSERT(available_pages[frame] > 0);
+    available_pages[frame]++;
+}
+
+void ReleaseFrame(int frame)
+{
+    ASSERT(available_pages[frame] > 0);
+    available_pages[frame]--;
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
 // 	Create an address space to run a user program.
@@ -152,6 +330,11 @@ AddrSpace::AddrSpace(OpenFile *executable)
 		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
     	SwapHeader(&noffH);
     ASSERT(noffH.noffMagic == NOFFMAGIC);
+    vmStats = stats->NewProcessVM("executable", -1);
+    ring = NULL;
+    image = NULL;			// everything is loaded up front
+    on_disk = NULL;
+    page_sector = NULL;
 
 // how big is address space?
     size = noffH.code.size + noffH.initData.size + noffH.uninitData.size 
@@ -180,6 +363,15 @@ AddrSpace::AddrSpace(OpenFile *executable)
 					// a separate page, we could set its 
 					// pages to be read-only
     }
+    shm_base = numPages;
+    for (i = 0; i < MaxShmSegments; i++) {
+	shm_first[i] = -1;
+	shm_held[i] = FALSE;
+    }
+    stack_pages = NULL;
+    threads = 1;
+    page_lock = new Lock("page fault");
+    weight = FairWeight;
     
 // zero out the entire address space, to zero the unitialized data segment 
 // and the stack segment
@@ -203,12 +395,31 @@ AddrSpace::AddrSpace(OpenFile *executable)
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.  Nothing for now!
+// 	Dealloate an address space: detach shared memory, and give back
+//	the frames and swap sectors of a demand-paged space (a forked
+//	copy shares its frames with the original, so it keeps them).
+//	Runs inside Scheduler::Run, so nothing here may block.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
-   delete pageTable;
+   shmManager->DetachAll(this);
+   if(image != NULL && !forked) {
+      for(int i = 0; i < (int)numPages; i++) {
+         if(pageTable[i].valid)
+            ReleaseFrame(pageTable[i].physicalPage);
+         if(page_sector[i] >= 0)
+            available_sectors.Clear(page_sector[i]);
+      }
+   }
+   delete [] pageTable;
+   delete on_disk;
+   delete [] page_sector;
+   delete stack_pages;
+   delete page_lock;
+   delete ring;
+   if(image != NULL)
+      execCache->Put(image);
 }
 
 //----------------------------------------------------------------------
@@ -264,23 +475,25 @@ void AddrSpace::SaveState()
 
 void AddrSpace::RestoreState() 
 {
+    if (machine->pageTable == pageTable && machine->pageTableSize == numPages)
+	return;			// still loaded, as when threads share it
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
 }
 
 ///////////Added///////////////////////
-static int available_pages[NumPhysPages] = {0};
-static BitMap available_sectors(NumSectors);
 
 #ifdef FILESYS_NEEDED
 #include "synchdisk.h"
 #endif
 
 
-AddrSpace::AddrSpace(char* name)
+AddrSpace::AddrSpace(char* name, int pid)
 {
-	OpenFile* executable = fileSystem->Open(name);
-    if(executable == NULL)
+    //The header and the open file come from the exec cache, so starting
+    //a program that has run recently doesn't touch the disk.
+    image = execCache->Get(name);
+    if(image == NULL)
     {		
     	printf("Unable to open file %s\n", name);
 		throw 1;
@@ -293,37 +506,19 @@ AddrSpace::AddrSpace(char* name)
     forked = FALSE;
 
 	// initialize the fd list to include stdin and stdout
-	open_files.fd_put( (void*)0 );
-	open_files.fd_put( (void*)0 );
+	open_files.fd_put( (void*)0, FD_CONSOLE_IN );
+	open_files.fd_put( (void*)0, FD_CONSOLE_OUT );
 	
     //Save this so the address space can be constructed later.
     
-    filename = new char[strlen(name)];
+    filename = new char[strlen(name) + 1];
     
     strcpy(filename, name); //copy including null terminator
 	
-    //Read the executable header.
-    //printf("name: %s\n", filename);
-    executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
-    
-    delete executable;
-
-    if ((noffH.noffMagic != NOFFMAGIC) &&
-            (WordToHost(noffH.noffMagic) == NOFFMAGIC)) {
-        SwapHeader(&noffH);
-    }
-    if(noffH.noffMagic != NOFFMAGIC) {
-        DEBUG('u', "Attemted to execute non-noff executable\"%s\".",
-              executable);
-        throw 1;
-    }
+    noffH = image->noffH;
 
-    // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size
-           + UserStackSize;	// we need to increase the size
-                                // to leave room for the stack
-
-    numPages = divRoundUp(size, PageSize);
+    // how big is address space? (the stack is included)
+    numPages = image->numPages;
     ASSERT(numPages <= NumPhysPages);
     size = numPages * PageSize;
     stack_base = size - 16;
@@ -340,6 +535,8 @@ AddrSpace::AddrSpace(char* name)
 
     DEBUG('u', "Initializing address space, num pages %d, size 0x%x\n",
         numPages, size);
+    vmStats = stats->NewProcessVM(name, pid);
+    ring = NULL;
     
     //An empty page table.
     //Only load pages on demand.
@@ -353,6 +550,17 @@ AddrSpace::AddrSpace(char* name)
         pageTable[virt_page].dirty = FALSE;
         pageTable[virt_page].readOnly = FALSE;
     }
+
+    //No shared memory or thread stacks yet; they go past the stack.
+    shm_base = numPages;
+    for(int id = 0; id < MaxShmSegments; id++) {
+        shm_first[id] = -1;
+        shm_held[id] = FALSE;
+    }
+    stack_pages = new BitMap(numPages);
+    threads = 1;
+    page_lock = new Lock("page fault");
+    weight = FairWeight;
 }
 
 AddrSpace::AddrSpace(const AddrSpace& source)
@@ -365,6 +573,12 @@ AddrSpace::AddrSpace(const AddrSpace& source)
     stack_base = source.stack_base;
     argc = source.argc;
     argv = source.argv;
+    vmStats = stats->NewProcessVM(filename, -1);
+    ring = NULL;
+    image = source.image;
+    if(image != NULL) {
+        execCache->Hold(image);
+    }
 
     on_disk = new BitMap(numPages);
     pageTable = new TranslationEntry[numPages];
@@ -374,6 +588,21 @@ AddrSpace::AddrSpace(const AddrSpace& source)
         pageTable[i] = source.pageTable[i];
         page_sector[i] = -1;
     }
+
+    //Shared memory isn't inherited, and neither are other threads.
+    shm_base = source.shm_base;
+    for(int i = shm_base; i < (int)numPages; i++) {
+        pageTable[i].valid = FALSE;
+        pageTable[i].physicalPage = -1;
+    }
+    for(int id = 0; id < MaxShmSegments; id++) {
+        shm_first[id] = -1;
+        shm_held[id] = FALSE;
+    }
+    stack_pages = new BitMap(numPages);
+    threads = 1;
+    page_lock = new Lock("page fault");
+    weight = FairWeight;
 }
 
 int AddrSpace::createStackArgs(int argv_addr, char* name)
@@ -486,12 +715,111 @@ void AddrSpace::write(int addr, char* str, int bytes)
 	return;
 }
 
+//Return a pointer to virtual address "addr" inside its physical frame,
+//faulting the page in if needed. Valid up to the end of that page.
+//"writing" marks the page dirty, since the kernel is about to store
+//into it behind the MMU's back. Returns NULL on a bad address.
+char* AddrSpace::frame_addr(int addr, bool writing)
+{
+    int virt_page = addr / PageSize;
+    int frame;
+
+    if(addr < 0 || virt_page >= (int)numPages) {
+        return NULL;
+    }
+    frame = load_page(virt_page);
+    if(frame < 0) {
+        return NULL;
+    }
+    pageTable[virt_page].use = TRUE;
+    if(writing) {
+        pageTable[virt_page].dirty = TRUE;
+    }
+    return &(machine->mainMemory[frame * PageSize + addr % PageSize]);
+}
+
+//As frame_addr, but also hold the frame (see HoldFrame), so that it is
+//not paged out and reused while the disk transfers into or out of it;
+//the caller gives it back with ReleaseFrame. The frame is held before
+//anything else can run, so it cannot be stolen in between.
+char* AddrSpace::pin_frame(int addr, bool writing)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    char* ptr = frame_addr(addr, writing);
+
+    if(ptr != NULL) {
+        HoldFrame((ptr - machine->mainMemory) / PageSize);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    return ptr;
+}
+
+//Read up to "bytes" bytes from "file" straight into user memory at
+//"addr", one page at a time, with no kernel staging buffer. When the
+//file position and "addr" are sector aligned, whole sectors go from the
+//disk directly into the frame (see OpenFile::ReadAt).
+//Returns the number of bytes read, or -1 on a bad address.
+int AddrSpace::read_file(OpenFile* file, int addr, int bytes)
+{
+    int done = 0;
+
+    while(done < bytes) {
+        int chunk = PageSize - (addr + done) % PageSize;
+        if(chunk > bytes - done) {
+            chunk = bytes - done;
+        }
+        char* dst = pin_frame(addr + done, TRUE);
+        if(dst == NULL) {
+            return done > 0 ? done : -1;
+        }
+        int got = file->Read(dst, chunk);
+        ReleaseFrame((dst - machine->mainMemory) / PageSize);
+        if(got > 0) {
+            done += got;
+        }
+        if(got < chunk) {
+            break;
+        }
+    }
+    return done;
+}
+
+//Write "bytes" bytes of user memory at "addr" to "file", handing the
+//frames themselves to the file system rather than copying them first.
+//Returns the number of bytes written, or -1 on a bad address.
+int AddrSpace::write_file(OpenFile* file, int addr, int bytes)
+{
+    int done = 0;
+
+    while(done < bytes) {
+        int chunk = PageSize - (addr + done) % PageSize;
+        if(chunk > bytes - done) {
+            chunk = bytes - done;
+        }
+        char* src = pin_frame(addr + done, FALSE);
+        if(src == NULL) {
+            return done > 0 ? done : -1;
+        }
+        int put = file->Write(src, chunk);
+        ReleaseFrame((src - machine->mainMemory) / PageSize);
+        if(put > 0) {
+            done += put;
+        }
+        if(put < chunk) {
+            break;
+        }
+    }
+    return done;
+}
+
 int AddrSpace::readPage(int physicalPage, int virtualPage) {
     int sector = page_sector[virtualPage];
     if(sector < 0 || sector >= NumSectors) {
         return -1;
     }
     synchDisk->ReadSector(sector, &(machine->mainMemory[physicalPage * PageSize]));
+    stats->vm.swapReads++;
+    vmStats->swapReads++;
     return sector;
 }
 
@@ -507,15 +835,45 @@ int AddrSpace::writePage( int physicalPage, int virtualPage )
         page_sector[virtualPage] = sector;
     }
     synchDisk->WriteSector(sector, &(machine->mainMemory[physicalPage * PageSize]));
+    on_disk->Mark(virtualPage);
+    stats->vm.swapWrites++;
+    vmStats->swapWrites++;
     return sector;
 }
 
+//Count a serviced page fault, both system wide and for this process.
+//"start" is the simulated time at which the fault was taken.
+void AddrSpace::count_fault(VMFaultType type, unsigned long long start) {
+    unsigned long long ticks = stats->totalTicks - start;
+
+    stats->numPageFaults++;
+    stats->vm.RecordFault(type, ticks);
+    vmStats->RecordFault(type, ticks);
+}
+
 //Load page number "virt_page" into memory. Select a victum page
 //to swap out if necessary.
 //Returns the frame number, or -1 on error. Process should die on error.
+//Threads of the same space fault one at a time: a second thread faulting
+//on the page being loaded waits, and then finds it valid.
 int AddrSpace::load_page(int virt_page) {
-    TranslationEntry* page = &(pageTable[virt_page]);
+    int frame;
+
+    page_lock->Acquire();
+    frame = fault_in(virt_page);
+    page_lock->Release();
+    return frame;
+}
+
+//The body of load_page. Anything here may sleep (for a frame, or on the
+//disk), and meanwhile a sibling's Fork or ShmAttach can grow the space,
+//which reallocates the page table, so "page" is looked up again after
+//each sleep.
+int AddrSpace::fault_in(int virt_page) {
+    TranslationEntry* page;
     OpenFile* executable = NULL;
+    unsigned long long fault_start = stats->totalTicks;
+    VMFaultType fault_type = ZeroFillFault;
 
     DEBUG('u', "Load page 0x%x for thread %p\n", virt_page, this);
 
@@ -525,6 +883,7 @@ int AddrSpace::load_page(int virt_page) {
         return -1;
     }
 
+    page = &(pageTable[virt_page]);
     if(page->virtualPage != virt_page) {
         DEBUG('u', "Error index into page table on virtual page %d\n",
             virt_page);
@@ -538,30 +897,31 @@ int AddrSpace::load_page(int virt_page) {
         return page->physicalPage;
     }
 
-    //If memory space is available, put the page in memory.
-    DEBUG('s',"checking for space available\n");
-    for(int i = 0; i < NumPhysPages; i++) {
-        if(available_pages[i] == 0) {
-            DEBUG('u', "Found free page %d\n", i);
-            page->physicalPage = i;
-            available_pages[i] = 1;
-            break;
-        }
+    //Shared memory is always in memory while it is attached; past the
+    //stack, anything but another thread's stack is a hole.
+    if(virt_page >= shm_base && !stack_pages->Test(virt_page)) {
+        DEBUG('u', "Fault on unmapped page %d past the stack\n", virt_page);
+        return -1;
     }
 
-    //If no extra space exists in memory, push one of this processes current
-    //pages to disk. If impossible, yeild and try again later.
-    if(page->physicalPage == -1) {
-        page->physicalPage = store_page();
-        available_pages[page->physicalPage] = 1;
-        page->use = TRUE;
-    }
+    //If memory space is available, put the page in memory. If not, push
+    //one of this processes current pages to disk (yeilding until that
+    //is possible).
+    DEBUG('s',"checking for space available\n");
+    int frame = AllocFrame(this);
+    page = &(pageTable[virt_page]);
+    page->physicalPage = frame;
+    page->use = TRUE;
 
     if(on_disk->Test(virt_page)) {
         DEBUG('u', "Load page from disk into memory.\n");
 
         readPage(page->physicalPage, page->virtualPage);
-        return -1;
+        page = &(pageTable[virt_page]);
+        page->valid = TRUE;
+        page->dirty = FALSE;
+        count_fault(SwapInFault, fault_start);
+        return page->physicalPage;
     } else {
         //Zero pages that aren't coming from disk. This includes text and data
         //pages (before the data is generated). The page might contain stack
@@ -569,6 +929,19 @@ int AddrSpace::load_page(int virt_page) {
         bzero(&(machine->mainMemory[page->physicalPage * PageSize]), PageSize);
     }
 
+    //The first few pages of the program may already be cached, exactly as
+    //they were loaded the first time.
+    if(image->FillPage(virt_page, 
+            &(machine->mainMemory[frame * PageSize]), &fault_type)) {
+        DEBUG('u', "Copied page %d from the exec cache.\n", virt_page);
+        page = &(pageTable[virt_page]);
+        page->valid = TRUE;
+        page->dirty = FALSE;
+        count_fault(fault_type, fault_start);
+        return page->physicalPage;
+    }
+    page = &(pageTable[virt_page]);
+
 
     //if the page with this virtual address contains text, load it from the
     //executable.
@@ -581,12 +954,9 @@ int AddrSpace::load_page(int virt_page) {
         int file_offset = noffH.code.inFileAddr;
 
         DEBUG('u', "Generating text section from executable '%s'\n", filename);
+        fault_type = CodeFault;
 
-        executable = fileSystem->Open(filename);
-        if(executable == NULL) {
-            DEBUG('u', "Unable to open file '%s'.\n", filename);
-            return -1;
-        }
+        executable = image->file;
 
         //If the text begins in this page, use the header to decide where to
         //set the offset. Otherwise start at the beginning of the page.
@@ -611,6 +981,7 @@ int AddrSpace::load_page(int virt_page) {
         DEBUG('u', "File offset:0x%x\n", file_offset);
         executable->ReadAt(&(machine->mainMemory[start]), end - start,
             file_offset);
+        page = &(pageTable[virt_page]);
     } else {
         DEBUG('u', "Section contains no code.\n");
     }
@@ -625,12 +996,9 @@ int AddrSpace::load_page(int virt_page) {
         int file_offset = noffH.initData.inFileAddr;
 
         DEBUG('u', "Generating data section from executable '%s'\n", filename);
+        fault_type = DataFault;
 
-        executable = fileSystem->Open(filename);
-        if(executable == NULL) {
-            DEBUG('u', "Unable to open file '%s'.\n", filename);
-            return -1;
-        }
+        executable = image->file;
 
         //If the text begins in this page, use the header to decide where to
         //set the offset. Otherwise start at the beginning of the page.
@@ -652,18 +1020,24 @@ int AddrSpace::load_page(int virt_page) {
         DEBUG('u', "File offset:0x%x\n", file_offset);
         executable->ReadAt(&(machine->mainMemory[start]), end - start,
             file_offset);
+        page = &(pageTable[virt_page]);
     } else {
         DEBUG('u', "Section contains no initData.\n");
     }
 
     page->valid = TRUE;
+    page->dirty = FALSE;
 
-    delete executable;
-    return page->physicalPage;
+    if(fault_type != ZeroFillFault) {
+        image->SavePage(virt_page, 
+            &(machine->mainMemory[frame * PageSize]), fault_type);
+    }
+    count_fault(fault_type, fault_start);
+    return frame;
 }
 
 int AddrSpace::try_store_page() {
-    TranslationEntry* best_page = &(pageTable[victum_offset]);
+    TranslationEntry* best_page = NULL;
     bool best_used = FALSE;
     int unused_offset = -1;
     int rtn = -1;
@@ -671,12 +1045,15 @@ int AddrSpace::try_store_page() {
     DEBUG('u', "Swaping victum page to disk.\n");
     
     //Select the best page to replace.
-    for(int i = 1; i < numPages; i++) {
+    for(int i = 0; i < numPages; i++) {
         TranslationEntry* curr_page = 
             &(pageTable[(victum_offset + i) % numPages]);
         bool curr_used = curr_page->use;
 
-        if(!curr_page->valid) {
+        //Shared memory has to stay where the other processes see it, and
+        //a held frame may be in the middle of a disk transfer.
+        if(!curr_page->valid || 
+                available_pages[curr_page->physicalPage] > 1) {
             continue;
         }
 
@@ -691,16 +1068,12 @@ int AddrSpace::try_store_page() {
             }
         }
 
-        //If the current best selection uses non-read-only shared memory,
-        //anything is better.
-        if(!best_page->readOnly && 
-                available_pages[best_page->physicalPage] > 1) {
+        if(best_page == NULL) {
             best_page = curr_page;
             best_used = curr_used;
             continue;
         }
 
-
         //If the current page is read_only memory
         if(best_page->readOnly && !curr_page->readOnly) {
             best_page = curr_page;
@@ -726,45 +1099,193 @@ int AddrSpace::try_store_page() {
         }
     }
 
-    //This means all pages in the current address space are shared memory. This
-    //means somehow the process set its own text section to shared. 
-    if(!best_page->readOnly &&
-            available_pages[best_page->physicalPage] > 1) {
-        DEBUG('u', "Only shared memory found in current space.\n");
+    //Nothing of ours but shared memory is in memory, so there is nothing
+    //we can give up.
+    if(best_page == NULL) {
+        DEBUG('u', "No private resident pages found in current space.\n");
         return -1;
     }
 
     //Try to make it so the page we are swaping in isn't the next one that
     //is attempted to be swapped out.
-    victum_offset = unused_offset;
+    if(unused_offset >= 0) {
+        victum_offset = unused_offset;
+    }
+
+    rtn = best_page->physicalPage;
+    DEBUG('u', "Swap out virt page %d, phys page %d\n",
+        best_page->virtualPage, rtn);
 
+    //Dirty pages have to be written to the swap disk first. Clean pages
+    //are either already there, or can be rebuilt from the executable.
     if(best_page->dirty || best_page->readOnly) {
-        while(writePage(best_page->physicalPage, best_page->virtualPage) < 0) {
+        while(writePage(rtn, best_page->virtualPage) < 0) {
             currentThread->Yield();
         }
-        best_page->valid = FALSE;
-        best_page->physicalPage = -1;
-
-        if(best_page->readOnly) {
-            available_pages[best_page->physicalPage]--;
-            best_page->readOnly = FALSE;
-            return -1;
-        }
+        stats->vm.dirtyEvictions++;
+        vmStats->dirtyEvictions++;
+    } else {
+        stats->vm.cleanEvictions++;
+        vmStats->cleanEvictions++;
     }
-    
-    DEBUG('u', "Swap out virt page %d, phys page %d\n",
-        best_page->virtualPage, best_page->physicalPage);
-    rtn = best_page->physicalPage;
-    available_pages[rtn] = 0;
+    best_page->valid = FALSE;
+    best_page->dirty = FALSE;
     best_page->physicalPage = -1;
 
+    if(best_page->readOnly) {
+        available_pages[rtn]--;
+        best_page->readOnly = FALSE;
+        return -1;
+    }
+
+    available_pages[rtn] = 0;
     return rtn;
 }
 
+//Add "pages" pages past the end of the address space, not yet mapped.
+//The page table is reallocated, so the machine is pointed at the new one
+//if this space is running. Returns the first new page.
+int AddrSpace::extend(int pages) {
+    int first = numPages;
+    TranslationEntry* new_table = new TranslationEntry[numPages + pages];
+    BitMap* new_on_disk = new BitMap(numPages + pages);
+    BitMap* new_stack_pages = new BitMap(numPages + pages);
+    int* new_sector = new int[numPages + pages];
+
+    for(int i = 0; i < first + pages; i++) {
+        if(i < first) {
+            new_table[i] = pageTable[i];
+            new_sector[i] = page_sector[i];
+            if(on_disk->Test(i)) {
+                new_on_disk->Mark(i);
+            }
+            if(stack_pages->Test(i)) {
+                new_stack_pages->Mark(i);
+            }
+            continue;
+        }
+        new_table[i].virtualPage = i;
+        new_table[i].physicalPage = -1;
+        new_table[i].valid = FALSE;
+        new_table[i].use = FALSE;
+        new_table[i].dirty = FALSE;
+        new_table[i].readOnly = FALSE;
+        new_sector[i] = -1;
+    }
+    delete [] pageTable;
+    delete on_disk;
+    delete stack_pages;
+    delete [] page_sector;
+    pageTable = new_table;
+    on_disk = new_on_disk;
+    stack_pages = new_stack_pages;
+    page_sector = new_sector;
+    numPages += pages;
+
+    if(currentThread->space == this) {
+        RestoreState();
+    }
+    return first;
+}
+
+//Find the first hole of "count" pages past the stack, where nothing is
+//mapped and no thread has its stack, extending the address space if
+//there is none. Returns the first page of the hole.
+int AddrSpace::find_hole(int count) {
+    int first = shm_base;
+
+    for(int i = shm_base; i < (int)numPages && i - first < count; i++) {
+        if(pageTable[i].valid || stack_pages->Test(i)) {
+            first = i + 1;
+        }
+    }
+    if(first + count > (int)numPages) {
+        extend(first + count - numPages);
+    }
+    return first;
+}
+
+//Map "count" frames, in order, into the first hole past the stack that
+//is big enough. Returns the first page they are mapped at.
+int AddrSpace::map_frames(int* frames, int count) {
+    int first = find_hole(count);
+
+    for(int i = 0; i < count; i++) {
+        TranslationEntry* page = &(pageTable[first + i]);
+        page->physicalPage = frames[i];
+        page->valid = TRUE;
+        page->use = FALSE;
+        page->dirty = FALSE;
+    }
+    return first;
+}
+
+//Unmap the "count" pages starting at "first", leaving a hole.
+void AddrSpace::unmap_frames(int first, int count) {
+    for(int i = first; i < first + count; i++) {
+        pageTable[i].valid = FALSE;
+        pageTable[i].physicalPage = -1;
+    }
+}
+
+//Carve a stack of "count" pages for a new thread out of the first hole
+//past the stack. Its pages are zero filled on demand, and paged like any
+//other. Returns the first page.
+int AddrSpace::alloc_stack(int count) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int first = find_hole(count);
+
+    for(int i = first; i < first + count; i++) {
+        stack_pages->Mark(i);
+    }
+    threads++;
+    (void) interrupt->SetLevel(oldLevel);
+    return first;
+}
+
+//Give back the stack of a thread that has finished, with its frames and
+//swap sectors, leaving a hole. Returns the number of threads left.
+int AddrSpace::free_stack(int first, int count) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    for(int i = first; i < first + count; i++) {
+        if(pageTable[i].valid) {
+            ReleaseFrame(pageTable[i].physicalPage);
+        }
+        if(page_sector[i] >= 0) {
+            available_sectors.Clear(page_sector[i]);
+            page_sector[i] = -1;
+        }
+        if(on_disk->Test(i)) {
+            on_disk->Clear(i);
+        }
+        pageTable[i].valid = FALSE;
+        pageTable[i].physicalPage = -1;
+        stack_pages->Clear(i);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    return remove_thread();
+}
+
+//One fewer thread runs in this space. Returns the number left; when it is
+//none, the last one to finish deletes the space.
+int AddrSpace::remove_thread() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int left = --threads;
+
+    (void) interrupt->SetLevel(oldLevel);
+    return left;
+}
+
 int AddrSpace::store_page() {
     int rtn;
     do {
         rtn = try_store_page();
+        //Let the other processes run (and maybe free some memory) before
+        //trying again.
+        if(rtn == -1) {
+            currentThread->Yield();
+        }
     } while(rtn == -1);
 
     return rtn;
@@ -18,12 +18,22 @@
 #include "bitmap.h"
 #include "fd_list.h"
 #include "noff.h"
+#include "stats.h"
+#include "shm.h"
+
+class SyscallRing;
+class ExecImage;
+class AddrSpace;
+class Lock;
 
-#define SHM_CREATE 0
-#define SHM_USE 1
 #define UserStackSize		1024 	// increase this as necessary!
-void* attachSharedMemory(int key);
-int allocateSharedMemory(int key, int numbytes, int flag);
+#define ThreadStackPages	(UserStackSize / PageSize)
+					// stack of each thread started by Fork
+void SwapHeader(NoffHeader *noffH);	// NOFF header to host byte order
+int AllocFrame(AddrSpace* space);	// a free frame, evicting one of 
+					// space's pages if there is none
+void HoldFrame(int frame);		// one more page maps the frame
+void ReleaseFrame(int frame);		// one fewer; free it at none
 
 class AddrSpace {
   public:
@@ -40,23 +50,47 @@ class AddrSpace {
     void RestoreState();		// info on a context switch 
 	
 	FD_List open_files;			// store open file info
+	bool close_fd(int fd);			// close a file or pipe end
+	void close_files();			// close everything, on exit
+	void inherit_files(AddrSpace* parent);	// share the parent's fds
 	
 	///////added by Can Li///////////////////////
-	AddrSpace(char* name);//create address space by its file name
+	AddrSpace(char* name, int pid = -1);//create address space by its file name
 	//Make a copy of the address space (for fork).
     AddrSpace(const AddrSpace& source);
 	int createStackArgs(int argv_addr, char* name); //create stack space for this process, return stack_base
 	
 	char* read(int addr, int bytes);//read at virtual address
 	void write(int addr, char* str, int bytes);//write str to virtual address
+	char* frame_addr(int addr, bool writing);//virtual address -> frame pointer
+	char* pin_frame(int addr, bool writing);//frame_addr, held until ReleaseFrame
+	int read_file(OpenFile* file, int addr, int bytes);//file -> user memory, no copy
+	int write_file(OpenFile* file, int addr, int bytes);//user memory -> file, no copy
 	
 	int load_page(int virt_page);//load virt_page into memory
+	void count_fault(VMFaultType type, unsigned long long start);//account for a serviced fault
 	
 	int readPage( int physicalPage, int virtualPage );//read from physicalPage
     int writePage( int physicalPage, int virtualPage );//write virtualPage to that physicalPage
     
     int store_page();
     int try_store_page();
+    
+    int extend(int pages);//add pages past the end, return the first
+    int map_frames(int* frames, int count);//map shared frames, return first page
+    void unmap_frames(int first, int count);//and take them out again
+    int alloc_stack(int count);//stack for one more thread (see Fork)
+    int free_stack(int first, int count);//its thread is done; threads left
+    int remove_thread();//a thread without its own stack is done; threads left
+    int num_threads() { return threads; }
+    int shm_first[MaxShmSegments];	// first page of each attached segment,
+					// or -1 (see shm.h)
+    bool shm_held[MaxShmSegments];	// segments ShmCreate returned to it
+    int weight;				// CPU share under the fair-share
+					// scheduler (see scheduler.h)
+    
+    VMStats *vmStats;			// this process's VM event counters
+    SyscallRing *ring;			// batched syscall rings, if registered
 	/////////////////////////////////////////////
 
   private:
@@ -66,10 +100,19 @@ class AddrSpace {
 					// address space
 	///////added by Can Li///////////////////////				
     char* filename;
+    ExecImage* image;			// cached executable (see execcache.h)
     NoffHeader noffH;
     BitMap* on_disk;
     int* page_sector;
     int victum_offset;
+    int shm_base;			// pages from here on are shared memory
+					// or stacks of threads
+    BitMap* stack_pages;		// which of those are stacks
+    int threads;			// threads running in this space
+    Lock* page_lock;			// one fault at a time, since threads
+					// started by Fork share the space
+    int fault_in(int virt_page);	// load_page, with page_lock held
+    int find_hole(int count);		// unused pages past the stack
     int stack_base;
     int argc;
     int argv;
@@ -0,0 +1,213 @@
+// aio.cc 
+//	Routines to queue asynchronous file transfers for user programs,
+//	and the kernel thread that carries them out.
+//
+//	The I/O thread does the transfer with no lock held, so other
+//	threads keep running while it waits on the disk.
+
+#include "copyright.h"
+#include "system.h"
+#include "aio.h"
+
+//----------------------------------------------------------------------
+// AioServe
+// 	Entry point of the I/O thread.  We can't fork a member function,
+//	so this just calls AioManager::Serve.
+//
+//	"arg" is the AioManager, cast to an int
+//----------------------------------------------------------------------
+
+static void
+AioServe(int arg)
+{
+    ((AioManager *) arg)->Serve();
+}
+
+//----------------------------------------------------------------------
+// AioManager::AioManager
+// 	Initialize an empty request table.  The I/O thread is not started
+//	until a user program first asks for it, so that programs which
+//	never use asynchronous I/O are scheduled exactly as before.
+//----------------------------------------------------------------------
+
+AioManager::AioManager()
+{
+    for (int i = 0; i < MaxAioRequests; i++)
+	requests[i].inUse = FALSE;
+    queue = new SynchList;
+    lock = new Lock("aio table");
+    finished = new Condition("aio finished");
+    worker = NULL;
+}
+
+//----------------------------------------------------------------------
+// AioManager::~AioManager
+// 	De-allocate the request table.
+//----------------------------------------------------------------------
+
+AioManager::~AioManager()
+{
+    delete queue;
+    delete lock;
+    delete finished;
+}
+
+//----------------------------------------------------------------------
+// AioManager::Submit
+// 	Queue a transfer for the I/O thread, and return its handle without
+//	waiting for it.
+//
+//	"op" -- read from or write to "file"
+//	"space" -- the address space the buffer is in
+//	"addr", "size" -- the user buffer
+//----------------------------------------------------------------------
+
+int
+AioManager::Submit(AioOp op, AddrSpace *space, OpenFile *file, 
+		int addr, int size)
+{
+    AioRequest *req;
+    int handle;
+
+    lock->Acquire();
+    for (handle = 0; handle < MaxAioRequests; handle++)
+	if (!requests[handle].inUse)
+	    break;
+    if (handle == MaxAioRequests) {
+	lock->Release();
+	DEBUG('f', "Asynchronous I/O table is full.\n");
+	return -1;
+    }
+    req = &requests[handle];
+    req->inUse = TRUE;
+    req->done = FALSE;
+    req->op = op;
+    req->space = space;
+    req->file = file;
+    req->addr = addr;
+    req->size = size;
+    req->result = -1;
+    if (worker == NULL) {
+	worker = new Thread("aio worker");
+	worker->Fork(AioServe, (int) this);
+    }
+    lock->Release();
+
+    DEBUG('f', "Queued asynchronous %s of %d bytes, handle %d.\n", 
+		(op == AioReadOp) ? "read" : "write", size, handle);
+    queue->Append((void *) req);
+    return handle;
+}
+
+//----------------------------------------------------------------------
+// AioManager::Wait
+// 	Wait for a request to finish, hand back its result, and free its
+//	handle.  A handle can only be waited for once, and only by the
+//	address space that submitted it.
+//----------------------------------------------------------------------
+
+int
+AioManager::Wait(AddrSpace *space, int handle)
+{
+    AioRequest *req;
+    int result;
+
+    if (handle < 0 || handle >= MaxAioRequests)
+	return -1;
+    req = &requests[handle];
+
+    lock->Acquire();
+    if (!req->inUse || req->space != space) {
+	lock->Release();
+	return -1;
+    }
+    while (!req->done)
+	finished->Wait(lock);
+    result = req->result;
+    req->inUse = FALSE;
+    lock->Release();
+    return result;
+}
+
+//----------------------------------------------------------------------
+// AioManager::Pending
+// 	Return TRUE if "space" (any process, if NULL) has a request on 
+//	"file" (any file, if NULL) that has not finished.  Called with the
+//	lock held.
+//----------------------------------------------------------------------
+
+bool
+AioManager::Pending(AddrSpace *space, OpenFile *file)
+{
+    for (int i = 0; i < MaxAioRequests; i++) {
+	AioRequest *req = &requests[i];
+	if (req->inUse && !req->done 
+		&& (space == NULL || req->space == space)
+		&& (file == NULL || req->file == file))
+	    return TRUE;
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// AioManager::Drain
+// 	Wait until no request of "space" (of any process sharing the 
+//	file, if NULL) on "file" is in flight.  The open-file table calls
+//	this before deleting the OpenFile, so the I/O thread never
+//	touches a file that is gone.  Results stay around for AioWait.
+//----------------------------------------------------------------------
+
+void
+AioManager::Drain(AddrSpace *space, OpenFile *file)
+{
+    lock->Acquire();
+    while (Pending(space, file))
+	finished->Wait(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// AioManager::Release
+// 	Wait for all of "space"'s requests and free their handles.  Called
+//	when the process finishes, before its memory is de-allocated.
+//----------------------------------------------------------------------
+
+void
+AioManager::Release(AddrSpace *space)
+{
+    lock->Acquire();
+    while (Pending(space, NULL))
+	finished->Wait(lock);
+    for (int i = 0; i < MaxAioRequests; i++)
+	if (requests[i].inUse && requests[i].space == space)
+	    requests[i].inUse = FALSE;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// AioManager::Serve
+// 	Carry out queued transfers, one at a time, forever.  The transfer
+//	goes straight between the file and the frames of the submitting
+//	address space, faulting its pages in as needed; that space need 
+//	not be the one loaded into the machine.
+//----------------------------------------------------------------------
+
+void
+AioManager::Serve()
+{
+    for (;;) {
+	AioRequest *req = (AioRequest *) queue->Remove();
+	int result;
+
+	if (req->op == AioReadOp)
+	    result = req->space->read_file(req->file, req->addr, req->size);
+	else
+	    result = req->space->write_file(req->file, req->addr, req->size);
+
+	lock->Acquire();
+	req->result = result;
+	req->done = TRUE;
+	finished->Broadcast(lock);
+	lock->Release();
+    }
+}
@@ -0,0 +1,79 @@
+// aio.h 
+//	Data structures for asynchronous file I/O from user programs.
+//
+//	AioRead and AioWrite queue a transfer for a kernel I/O thread
+//	and return a handle right away; the user program only blocks
+//	when it calls AioWait on that handle to collect the result.
+//	This lets a program overlap disk latency with computation.
+//
+//	Requests are served in the order they were submitted, by one
+//	worker thread, using the same page-at-a-time transfer as the
+//	Read and Write system calls (AddrSpace::read_file/write_file).
+//	The worker uses, and advances, the open file's own position,
+//	so a synchronous Read or Write of the same file while a request
+//	is outstanding lands wherever the worker has got to.
+
+#ifndef AIO_H
+#define AIO_H
+
+#include "copyright.h"
+#include "synchlist.h"
+#include "filesys.h"
+
+class AddrSpace;
+class Thread;
+
+#define MaxAioRequests	64	// outstanding requests, system wide
+
+enum AioOp { AioReadOp, AioWriteOp };
+
+// The following class defines one asynchronous transfer.  Its index
+// in the request table is the handle the user program gets back.
+
+class AioRequest {
+  public:
+    bool inUse;			// slot holds a request not yet waited for
+    bool done;			// the transfer has finished
+    AioOp op;
+    AddrSpace *space;		// whose memory the buffer is in
+    OpenFile *file;
+    int addr;			// user virtual address of the buffer
+    int size;
+    int result;			// bytes transferred, or -1
+};
+
+// The following class defines the request table and the I/O thread
+// that serves it.
+
+class AioManager {
+  public:
+    AioManager();
+    ~AioManager();
+
+    int Submit(AioOp op, AddrSpace *space, OpenFile *file, 
+		int addr, int size);	// queue a transfer; return its 
+					// handle, or -1 if the table is full
+    int Wait(AddrSpace *space, int handle);
+					// block until "handle" is done and 
+					// return its result; -1 if "space"
+					// has no such request
+    void Drain(AddrSpace *space, OpenFile *file);
+					// block until every request of "space"
+					// on "file" (or on any file, if NULL)
+					// is done
+    void Release(AddrSpace *space);	// drain and forget all of "space"'s
+					// requests, before it goes away
+
+    void Serve();			// the I/O thread's loop; never returns
+
+  private:
+    bool Pending(AddrSpace *space, OpenFile *file);
+
+    AioRequest requests[MaxAioRequests];
+    SynchList *queue;			// submitted, not yet started
+    Lock *lock;				// protects "requests"
+    Condition *finished;		// signalled when a request is done
+    Thread *worker;			// started on the first Submit
+};
+
+#endif // AIO_H
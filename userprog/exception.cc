@@ -24,6 +24,16 @@
 #include "copyright.h"
 #include "system.h"
 #include "syscall.h"
+#include "syscalltable.h"
+#include "synchconsole.h"
+#include "aio.h"
+#include "ring.h"
+#include "execcache.h"
+#include "pipe.h"
+#include "proctable.h"
+#include "systrace.h"
+#include "shm.h"
+#include "futex.h"
 #include <string.h>
 #include <libgen.h>
 #include <unistd.h>
@@ -67,6 +77,9 @@ Create_Syscall_Func( unsigned int addr )
 		return;
 	}
 	
+	/* a cached copy of an executable by this name is about to go stale */
+	execCache->Invalidate( buf );
+	
 	/* tell the FS to make the file */
 	fileSystem->Create( buf, 0 );
 	DEBUG( 'f', "Created file: %s requested by userprog\n", buf );
@@ -105,10 +118,9 @@ Open_Syscall_Func( unsigned int addr )
 	
 	if( file )
 	{
-		/* put it on the threads fd list */
+		/* put it on the threads fd list (which closes it on failure) */
 		if( ( fd = currentThread->space->open_files.fd_put( file )) == -1 )
-			delete file;
-		if( fd == 0 ) return -1;
+			return -1;
 		DEBUG( 'f', "Opened file: %s requested by userprog\n", buf );
 		return fd;
 	}
@@ -122,8 +134,9 @@ Open_Syscall_Func( unsigned int addr )
 
 /**
  * Accessing the memory at location virt_addr, reading the data to be written
- * Copy it into a buffer then write the contents of that buffer to the file 
- * specified in ID; if ID is stdin (ConsoleInput in NachOS) it is an error.
+ * and write it to the file specified in ID, page by page straight out of the
+ * user's frames; if ID refers to stdin (ConsoleInput in NachOS) it is an error.
+ * Any fd can refer to the console, a file or a pipe, after Dup.
  *
  * Returns -1 on error and the amount of characters written otherwise.
  */
@@ -143,48 +156,50 @@ Write_Syscall_Func( unsigned int addr, int size, int fd )
 	if( size == 0 ) return 0;
 	if( size < 0 ) return -1;
 	
-	/* stdin = error */
-	if( fd == ConsoleInput )
+	switch( currentThread->space->open_files.fd_type( fd ) )
 	{
+	/* stdin = error */
+	case FD_CONSOLE_IN:
 		DEBUG( 'f', "You cannot write to stdin!\n" );
 		return -1;
-	}
 	
-	/* error  check */
-	char *buf = currentThread->space->read( addr, size );
-	if( buf == NULL )
+	/* output to console, through the buffered console device */
+	case FD_CONSOLE_OUT:
 	{
-		DEBUG( 'f', "Failed to alloc buffer in write_syscall.\n"); 
-		return -1;
-	}
-	
-	/* output to console */
-	if( fd == ConsoleOutput )
-	{
-		int count;
-		for( count = 0; count < size; ++count )
+		char out[ ConsoleBufferSize ]; // read() hands back a shared buffer
+		int count, chunk;
+		for( count = 0; count < size; count += chunk )
 		{
-			printf("%c", buf[ count ] ); // write to stdout directly
+			chunk = size - count;
+			if( chunk > ConsoleBufferSize ) chunk = ConsoleBufferSize;
+			bcopy( currentThread->space->read( addr + count, chunk ), out, chunk );
+			synchConsole->Write( out, chunk );
 		}
 		return count;
 	}
+	
+	/* pipes: only the write end can be written */
+	case FD_PIPE_WRITE:
+		return ((PipeBuffer *) currentThread->space->open_files.fd_get( fd ))->Write(
+					currentThread->space, addr, size );
+	case FD_PIPE_READ:
+		DEBUG( 'f', "You cannot write to the read end of a pipe!\n" );
+		return -1;
+	default:
+		break;
+	}
+	
 	/* write to the file specified if not stdout */
-	else
+	/* check if we have the fd open */
+	file = (OpenFile*) currentThread->space->open_files.fd_get( fd );
+	if( file == NULL )
 	{
-		/* check if we have the fd open */
-		file = 0;
-		file = (OpenFile*) currentThread->space->open_files.fd_get( fd );
-		if( file ) // not null, etc
-		{
-			int temp = file->Write( buf, size );			
-			return temp;
-		}
-		else
-		{
-			DEBUG( 'f', "Failed to write to file in write syscall (bad id).\n" );
-			return -1;
-		}
+		DEBUG( 'f', "Failed to write to file in write syscall (bad id).\n" );
+		return -1;
 	}
+	
+	/* hand the user's frames to the file system directly */
+	return currentThread->space->write_file( file, addr, size );
 } // write_syscall_func
 
 /**
@@ -203,61 +218,50 @@ Read_Syscall_Func( unsigned int addr, int size, int fd )
 	if( size < 0 ) return -1;
 	if( fd < 0 ) return -1;
 	
-	char *buf;
 	OpenFile *file;
-	buf = new char[ size ];
 	
-	/* checking errors */
-	if( fd == ConsoleOutput )
+	switch( currentThread->space->open_files.fd_type( fd ) )
 	{
+	/* checking errors */
+	case FD_CONSOLE_OUT:
 		DEBUG( 'f', "You cannot read from stdout!\n" );
 		return -1;
-	}
-	if( buf == NULL )
-	{
-		DEBUG( 'f', "Error allocating buffer in read syscall.\n" );
-	}
 	
-	/* read from stdi */ 
-	if( fd == ConsoleInput )
+	/* read from stdin, a line at a time through the console device */ 
+	case FD_CONSOLE_IN:
 	{
-		scanf( "%s", buf );
+		char in[ ConsoleBufferSize ];
+		int count = synchConsole->Read( in, size < ConsoleBufferSize ? size : ConsoleBufferSize );
 		
 		/* copy into memory for user */
-		currentThread->space->write( addr, buf, size );
-		/* we could have written less than size ... */
-		int str_len = strlen( buf );
-		delete[] buf;
-		return str_len-1;
+		if( count > 0 )
+			currentThread->space->write( addr, in, count );
+		return count;
 	}
-	/* read from file */
-	else
+	
+	/* pipes: only the read end can be read */
+	case FD_PIPE_READ:
+		return ((PipeBuffer *) currentThread->space->open_files.fd_get( fd ))->Read(
+					currentThread->space, addr, size );
+	case FD_PIPE_WRITE:
+		DEBUG( 'f', "You cannot read from the write end of a pipe!\n" );
+		return -1;
+	default:
+		break;
+	}
+	
+	/* read from file, straight into the user's frames */
+	file = (OpenFile *) currentThread->space->open_files.fd_get( fd );
+	if( file == NULL )
 	{
-		file = (OpenFile *) currentThread->space->open_files.fd_get( fd );
-		if( file )
-		{
-			int read_size = file->Read( buf, size );
-			if( read_size > 0 )
-			{
-				currentThread->space->write( addr, buf, size );
-				delete[] buf;
-				return read_size;
-			}
-			else if( read_size == 0 )
-			{
-				DEBUG( 'f', "Did not read any data on read().\n" );
-				delete[] buf;
-				return read_size;
-			}
-		}
-		else
-		{
-			DEBUG( 'f', "Bad id, failed to read from file.\n" );
-			delete[] buf;
-			return -1;
-		}
+		DEBUG( 'f', "Bad id, failed to read from file.\n" );
+		return -1;
 	}
-	return -1; // this should be an error if we get here
+	
+	int read_size = currentThread->space->read_file( file, addr, size );
+	if( read_size == 0 )
+		DEBUG( 'f', "Did not read any data on read().\n" );
+	return read_size;
 }
 
 /**
@@ -268,31 +272,169 @@ Read_Syscall_Func( unsigned int addr, int size, int fd )
 void
 Close_Syscall_Func( int fd )
 {
-	OpenFile *file = (OpenFile *)NULL;
-	
 	if( fd < 0 )
 	{
 		return;
 	}
 	
-	file = (OpenFile *)currentThread->space->open_files.fd_remove( fd );
+	/* a file, either end of a pipe or the console */
+	if( !currentThread->space->close_fd( fd ) )
+	{
+		DEBUG( 'f', "Tried to close a file that has not been opened by the current process.\n" );
+	}
+} // close syscall
+
+
+/**
+ * Create a pipe, and store the fd of its read end at virtual address addr
+ * and the fd of its write end just after it. Both stay open across Exec.
+ *
+ * Returns -1 on error and 0 otherwise.
+ */
+int
+Pipe_Syscall_Func( unsigned int addr )
+{
+	AddrSpace *space = currentThread->space;
+	PipeBuffer *pipe = new PipeBuffer;
+	int fds[2];
 	
-	if( file )
+	/* the open-file table opens each end for its entry */
+	fds[0] = space->open_files.fd_put( pipe, FD_PIPE_READ );
+	if( fds[0] == -1 )
 	{
-		delete file;
+		return -1; // the pipe went with it
 	}
-	else
+	fds[1] = space->open_files.fd_put( pipe, FD_PIPE_WRITE );
+	if( fds[1] == -1 )
 	{
-		DEBUG( 'f', "Tried to close a file that has not been opened by the current process.\n" );
+		space->close_fd( fds[0] ); // deletes the pipe
+		return -1;
 	}
-} // close syscall
+	
+	/* hand both back to the user, in its byte order */
+	fds[0] = WordToMachine( fds[0] );
+	fds[1] = WordToMachine( fds[1] );
+	space->write( addr, (char *) fds, sizeof( fds ) );
+	return 0;
+}
 
+/**
+ * Give what fd refers to a second fd, the lowest free one; both share the
+ * open-file table entry, and so the file position, until both are closed.
+ *
+ * Returns -1 on error and the new fd otherwise.
+ */
+int
+Dup_Syscall_Func( int fd )
+{
+	int new_fd = currentThread->space->open_files.fd_dup( fd );
+	
+	if( new_fd == -1 )
+	{
+		DEBUG( 'f', "Failed to dup fd %d (bad id or no fds left).\n", fd );
+	}
+	return new_fd;
+}
+
+/**
+ * Map the shared memory segment id into the current process.
+ *
+ * Returns 0 on error (the code is at 0, so no segment can be) and the
+ * segment's address otherwise.
+ */
+int
+ShmAttach_Syscall_Func( int id )
+{
+	int addr = shmManager->Attach( currentThread->space, id );
+	
+	if( addr == -1 )
+	{
+		DEBUG( 'u', "No shared memory segment %d to attach.\n", id );
+		return 0;
+	}
+	return addr;
+}
+
+/**
+ * Queue an asynchronous read or write of size bytes between the buffer at
+ * virtual address addr and the file specified by fd, and return at once.
+ * The console and pipes cannot be used asynchronously; it is an error.
+ *
+ * Returns -1 on error and a handle to pass to AioWait otherwise.
+ */
+int
+Aio_Syscall_Func( AioOp op, unsigned int addr, int size, int fd )
+{
+	OpenFile *file;
+	
+	/* error check */
+	if( size < 0 ) return -1;
+	
+	file = (OpenFile *) currentThread->space->open_files.fd_get( fd );
+	if( file == NULL || currentThread->space->open_files.fd_type( fd ) != FD_FILE )
+	{
+		DEBUG( 'f', "Bad id (or not a file), failed to queue asynchronous I/O.\n" );
+		return -1;
+	}
+	return aioManager->Submit( op, currentThread->space, file, addr, size );
+}
+
+/**
+ * Block until the request named by handle has finished.
+ *
+ * Returns -1 on a bad handle and the result of the Read or Write otherwise.
+ */
+int
+AioWait_Syscall_Func( int handle )
+{
+	return aioManager->Wait( currentThread->space, handle );
+}
+
+/**
+ * Register the batched syscall rings at virtual addresses ctl, sq and cq,
+ * each holding entries slots, replacing any registered before.
+ *
+ * Returns -1 on error and 0 otherwise.
+ */
+int
+RingSetup_Syscall_Func( unsigned int ctl, unsigned int sq, unsigned int cq, int entries )
+{
+	AddrSpace *space = currentThread->space;
+	
+	/* error check */
+	if( entries <= 0 ) return -1;
+	if( ctl % 4 != 0 || sq % 4 != 0 || cq % 4 != 0 ) return -1;
+	
+	delete space->ring;
+	space->ring = new SyscallRing( ctl, sq, cq, entries );
+	return 0;
+}
+
+/**
+ * Run up to toSubmit of the calls queued in the submission ring.
+ *
+ * Returns -1 if no rings are registered and the number consumed otherwise.
+ */
+int
+Enter_Syscall_Func( int toSubmit )
+{
+	AddrSpace *space = currentThread->space;
+	
+	if( space->ring == NULL )
+	{
+		DEBUG( 's', "Enter without RingSetup.\n" );
+		return -1;
+	}
+	if( toSubmit <= 0 ) return 0;
+	return space->ring->Enter( space, toSubmit );
+}
 
 /**
  * Create a process in SC_Exec
  */
 void createProcess(int arg)
 {
+	currentThread->LoadUserState();
 	currentThread->space->InitRegisters();
 	currentThread->space->RestoreState();
 	machine->Run();
@@ -302,20 +444,20 @@ void createProcess(int arg)
  * Execute a file
  */
 int 
-Exec_Syscall_Func( )
+Exec_Syscall_Func( unsigned int addr, int args )
 {
-	char *fileName = currentThread->space->read(machine->ReadRegister(4), 0); //get exe name from register 4
-	int args = machine->ReadRegister(5);//get argument from register 5
+	char *fileName = currentThread->space->read(addr, 0); //get exe name
 	//printf("currentThread: %s\n", currentThread->getName());
 	Thread* thread = new Thread("user", currentThread);
 	DEBUG('t', "\nExe File Name: %s\n", fileName);
 	SpaceId sid = -1;
 	try
 	{
-		thread->space = new AddrSpace( fileName );
+		thread->space = new AddrSpace( fileName, thread->getID() );
 		
 		if(args != 0)
 			thread->space->createStackArgs(args, fileName);
+		thread->space->inherit_files( currentThread->space );
 		sid = thread->getID();
 		thread->Fork(&createProcess, 0);
 		
@@ -324,6 +466,7 @@ Exec_Syscall_Func( )
 	catch (int e)
 	{
 		DEBUG('t', "Failed to create address space for EXE %s\n", fileName);
+		processTable->Discard( thread->getID() );
 		delete thread;
 		return -1;
 	}
@@ -331,39 +474,311 @@ Exec_Syscall_Func( )
 	return sid;	
 }
 
+/**
+ * Start running a thread made by Fork, in user mode, with the registers
+ * Fork set up for it.
+ */
+void startUserThread(int arg)
+{
+	currentThread->LoadUserState();
+	currentThread->space->RestoreState();
+	machine->Run();
+}
+
+/**
+ * Start a thread in the current address space, running the procedure at
+ * virtual address func on a stack of its own carved out of the space; it
+ * returns to virtual address done (ThreadExit, in start.s).
+ */
+void
+Fork_Syscall_Func( unsigned int func, unsigned int done )
+{
+	AddrSpace *space = currentThread->space;
+	Thread *thread = new Thread( "user thread" );
+	int first = space->alloc_stack( ThreadStackPages );
+	
+	thread->space = space;
+	thread->pid = currentThread->pid; // same process
+	thread->stackPage = first;
+	
+	/* as InitRegisters, but at func and on the new stack */
+	for( int i = 0; i < NumTotalRegs; i++ )
+		thread->setUserRegister( i, 0 );
+	thread->setUserRegister( PCReg, func );
+	thread->setUserRegister( NextPCReg, func + 4 );
+	thread->setUserRegister( RetAddrReg, done );
+	thread->setUserRegister( StackReg, ( first + ThreadStackPages ) * PageSize - 16 );
+	
+	DEBUG( 't', "Forked user thread at 0x%x, stack at page %d\n", func, first );
+	thread->Fork( &startUserThread, 0 );
+}
+
 /**
  * Exit current executable
  */
 void 
-Exit_Syscall_Func()
+Exit_Syscall_Func( int status )
 {
-	int status = machine->ReadRegister(4);
+	synchConsole->Flush(); // don't leave a partial line behind
 	currentThread->notifyParent(status);//doesn't matter what the value of status is
 	currentThread->Finish();
 }
 
 /**
- * Join the child
+ * Join the child: wait for it to exit, if it has not already.
+ * A child can only be joined once.
+ *
+ * Returns its exit status, or -1 if cid is not a child of this process.
  */
 int 
-Join_Syscall_Func()
+Join_Syscall_Func( int cid )
 {
-	int cid = machine->ReadRegister(4);//child thread id
-	if(cid >=0 && currentThread->child != NULL)
+	int status;
+	
+	DEBUG('t', "Waiting on child process %d\n", cid);
+	if( processTable->Join( currentThread->getID(), cid, &status ) == -1 )
+		return -1;
+	return status;
+}
+
+/**
+ * Join whichever child exits first, storing its exit status at virtual
+ * address addr (unless addr is 0).
+ *
+ * Returns the id of that child, or -1 if there are no children to wait for.
+ */
+int
+WaitAny_Syscall_Func( unsigned int addr )
+{
+	int status;
+	int cid = processTable->WaitAny( currentThread->getID(), &status );
+	
+	if( cid != -1 && addr != 0 )
 	{
-		ChildThread* childRecord = currentThread->child;
-		do
-		{
-			if(childRecord->id == cid)//find this child
-			{
-				DEBUG('t', "Waiting on child thread %d\n", cid);
-				childRecord->join_sem->P();//would be V() in destructor of child Thread
-				return 0;
-			}
-			childRecord = childRecord->next;
-		} while(childRecord != currentThread->child);
+		status = WordToMachine( status );
+		currentThread->space->write( addr, (char *) &status, sizeof( status ) );
 	}
-	return -1;
+	return cid;
+}
+
+//----------------------------------------------------------------------
+// Syscall handlers
+//	Argument marshalling for the dispatch table: each takes the
+//	argument registers in "args", calls the routine above that does
+//	the work, and returns the value for r2.
+//----------------------------------------------------------------------
+
+static int
+Halt_Syscall( int *args )
+{
+	DEBUG( 's', "Shutdown, initiated by user program.\n" );
+	synchConsole->Flush();
+	interrupt->Halt();
+	return 0; // not reached
+}
+
+static int
+Exit_Syscall( int *args )
+{
+	Exit_Syscall_Func( args[0] );
+	return 0; // not reached
+}
+
+static int
+Fork_Syscall( int *args )
+{
+	Fork_Syscall_Func( args[0], args[1] );
+	return 0;
+}
+
+static int
+Yield_Syscall( int *args )
+{
+	currentThread->Yield();
+	return 0;
+}
+
+static int
+Exec_Syscall( int *args )
+{
+	return Exec_Syscall_Func( args[0], args[1] );
+}
+
+static int
+Join_Syscall( int *args )
+{
+	return Join_Syscall_Func( args[0] );
+}
+
+static int
+Create_Syscall( int *args )
+{
+	Create_Syscall_Func( args[0] );
+	return 0;
+}
+
+static int
+Open_Syscall( int *args )
+{
+	return Open_Syscall_Func( args[0] );
+}
+
+static int
+Read_Syscall( int *args )
+{
+	return Read_Syscall_Func( args[0], args[1], args[2] );
+}
+
+static int
+Write_Syscall( int *args )
+{
+	return Write_Syscall_Func( args[0], args[1], args[2] );
+}
+
+static int
+Close_Syscall( int *args )
+{
+	Close_Syscall_Func( args[0] );
+	return 0;
+}
+
+static int
+AioRead_Syscall( int *args )
+{
+	return Aio_Syscall_Func( AioReadOp, args[0], args[1], args[2] );
+}
+
+static int
+AioWrite_Syscall( int *args )
+{
+	return Aio_Syscall_Func( AioWriteOp, args[0], args[1], args[2] );
+}
+
+static int
+AioWait_Syscall( int *args )
+{
+	return AioWait_Syscall_Func( args[0] );
+}
+
+static int
+RingSetup_Syscall( int *args )
+{
+	return RingSetup_Syscall_Func( args[0], args[1], args[2], args[3] );
+}
+
+static int
+Enter_Syscall( int *args )
+{
+	return Enter_Syscall_Func( args[0] );
+}
+
+static int
+Pipe_Syscall( int *args )
+{
+	return Pipe_Syscall_Func( args[0] );
+}
+
+static int
+WaitAny_Syscall( int *args )
+{
+	return WaitAny_Syscall_Func( args[0] );
+}
+
+static int
+Dup_Syscall( int *args )
+{
+	return Dup_Syscall_Func( args[0] );
+}
+
+static int
+TraceDump_Syscall( int *args )
+{
+	return syscallTrace->Dump();
+}
+
+static int
+ShmCreate_Syscall( int *args )
+{
+	return shmManager->Create( currentThread->space, args[0], args[1] );
+}
+
+static int
+ShmAttach_Syscall( int *args )
+{
+	return ShmAttach_Syscall_Func( args[0] );
+}
+
+static int
+ShmDetach_Syscall( int *args )
+{
+	return shmManager->Detach( currentThread->space, args[0] );
+}
+
+static int
+Sleep_Syscall( int *args )
+{
+	currentThread->SleepFor( args[0] );
+	return 0;
+}
+
+static int
+SetWeight_Syscall( int *args )
+{
+	AddrSpace *space = currentThread->space;
+	if( args[0] <= 0 || args[0] > FairMaxWeight )
+		return -1;
+	int old = space->weight;
+	space->weight = args[0];
+	return old;
+}
+
+static int
+FutexWait_Syscall( int *args )
+{
+	return futexTable->Wait( currentThread->space, args[0], args[1] );
+}
+
+static int
+FutexWake_Syscall( int *args )
+{
+	return futexTable->Wake( currentThread->space, args[0], args[1] );
+}
+
+//----------------------------------------------------------------------
+// RegisterSyscalls
+// 	Fill in the system call dispatch table.  Called once, at startup.
+//----------------------------------------------------------------------
+
+void
+RegisterSyscalls()
+{
+	RegisterSyscall( SC_Halt, "Halt", 0, Halt_Syscall );
+	RegisterSyscall( SC_Exit, "Exit", 1, Exit_Syscall );
+	RegisterSyscall( SC_Exec, "Exec", 2, Exec_Syscall );
+	RegisterSyscall( SC_Join, "Join", 1, Join_Syscall );
+	RegisterSyscall( SC_Create, "Create", 1, Create_Syscall );
+	RegisterSyscall( SC_Open, "Open", 1, Open_Syscall );
+	RegisterSyscall( SC_Read, "Read", 3, Read_Syscall );
+	RegisterSyscall( SC_Write, "Write", 3, Write_Syscall );
+	RegisterSyscall( SC_Close, "Close", 1, Close_Syscall );
+	RegisterSyscall( SC_Fork, "Fork", 2, Fork_Syscall );
+	RegisterSyscall( SC_Yield, "Yield", 0, Yield_Syscall );
+	RegisterSyscall( SC_AioRead, "AioRead", 3, AioRead_Syscall );
+	RegisterSyscall( SC_AioWrite, "AioWrite", 3, AioWrite_Syscall );
+	RegisterSyscall( SC_AioWait, "AioWait", 1, AioWait_Syscall );
+	RegisterSyscall( SC_RingSetup, "RingSetup", 4, RingSetup_Syscall );
+	RegisterSyscall( SC_Enter, "Enter", 1, Enter_Syscall );
+	RegisterSyscall( SC_Pipe, "Pipe", 1, Pipe_Syscall );
+	RegisterSyscall( SC_WaitAny, "WaitAny", 1, WaitAny_Syscall );
+	RegisterSyscall( SC_Dup, "Dup", 1, Dup_Syscall );
+	RegisterSyscall( SC_TraceDump, "TraceDump", 0, TraceDump_Syscall );
+	RegisterSyscall( SC_ShmCreate, "ShmCreate", 2, ShmCreate_Syscall );
+	RegisterSyscall( SC_ShmAttach, "ShmAttach", 1, ShmAttach_Syscall );
+	RegisterSyscall( SC_ShmDetach, "ShmDetach", 1, ShmDetach_Syscall );
+	RegisterSyscall( SC_Sleep, "Sleep", 1, Sleep_Syscall );
+	RegisterSyscall( SC_SetWeight, "SetWeight", 1, SetWeight_Syscall );
+	RegisterSyscall( SC_FutexWait, "FutexWait", 2, FutexWait_Syscall );
+	RegisterSyscall( SC_FutexWake, "FutexWake", 2, FutexWake_Syscall );
 }
 
 void
@@ -376,54 +791,7 @@ ExceptionHandler(ExceptionType which)
 	if( which == SyscallException )
 	{
 		/* debug flag s for syscall? */
-		if( type == SC_Halt )
-		{
-			DEBUG( 's', "Shutdown, initiated by user program.\n" );
-			interrupt->Halt();
-		}
-		else if( type == SC_Create )
-		{
-			DEBUG( 's', "Create, initiated by user program.\n" );
-			Create_Syscall_Func( machine->ReadRegister(4) );
-		}
-		else if( type == SC_Open )
-		{
-			DEBUG( 's', "Open, initiated by user program.\n" );
-			sys_ret = Open_Syscall_Func( machine->ReadRegister(4) );
-		}
-		else if( type == SC_Write )
-		{
-			DEBUG( 's', "Write, initiated by user program.\n" );
-			sys_ret = Write_Syscall_Func( machine->ReadRegister(4),
-										  machine->ReadRegister(5), machine->ReadRegister(6) );
-		}
-		else if( type == SC_Read )
-		{
-			DEBUG( 's', "Read, initiated by user program.\n" );
-			sys_ret = Read_Syscall_Func( machine->ReadRegister(4),
-										  machine->ReadRegister(5), machine->ReadRegister(6) );
-		}
-		else if( type == SC_Close )
-		{
-			DEBUG( 's', "Close, initiated by user program.\n" );
-			Close_Syscall_Func( machine->ReadRegister(4) );
-		}
-		else if( type == SC_Exit )
-		{
-			DEBUG( 's', "Exit, initiated by user program.\n" );
-			Exit_Syscall_Func();
-		}
-		else if( type == SC_Exec )
-		{
-			DEBUG( 's', "Exec, initiated by user program.\n" );
-			sys_ret = Exec_Syscall_Func( );
-		}
-		else if( type == SC_Join )
-		{
-			DEBUG( 's', "Join, initiated by user program.\n" );
-			sys_ret = Join_Syscall_Func();
-		}
-		else 
+		if( !DispatchSyscall( type, &sys_ret ) )
 		{
 			printf( "Unexpected user mode exception %d %d.\n", which, type );
 			ASSERT(FALSE);
@@ -439,6 +807,8 @@ ExceptionHandler(ExceptionType which)
 	}
 	else if( which == PageFaultException)
 	{
+		// load_page does the fault accounting (stats->numPageFaults and
+		// the VM counters), since kernel copies fault pages in as well
 		int badAddr = machine->ReadRegister(BadVAddrReg);
 		DEBUG('t', "PageFault on Address: 0x%x, on Page: %d\n", badAddr, badAddr / PageSize);
 		if(currentThread->space == NULL)
@@ -0,0 +1,253 @@
+// execcache.cc 
+//	Routines to look up, load and invalidate cached executables.
+
+#include "copyright.h"
+#include "system.h"
+#include "execcache.h"
+#include <string.h>
+
+//----------------------------------------------------------------------
+// ExecImage::ExecImage
+// 	Set up a cached image of an executable, from its open file and
+//	its already checked NOFF header.
+//----------------------------------------------------------------------
+
+ExecImage::ExecImage(char *fileName, OpenFile *executable, NoffHeader *hdr)
+{
+    int size;
+
+    name = new char[strlen(fileName) + 1];
+    strcpy(name, fileName);
+    file = executable;
+    noffH = *hdr;
+
+    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size
+           + UserStackSize;
+    numPages = divRoundUp(size, PageSize);
+
+    refs = 0;
+    stale = FALSE;
+    lastUse = 0;
+    hot = new char[ExecHotPages * PageSize];
+    for (int i = 0; i < ExecHotPages; i++)
+	hotValid[i] = FALSE;
+}
+
+//----------------------------------------------------------------------
+// ExecImage::~ExecImage
+// 	Close the executable and free the cached pages.
+//----------------------------------------------------------------------
+
+ExecImage::~ExecImage()
+{
+    delete file;
+    delete [] hot;
+    delete [] name;
+}
+
+//----------------------------------------------------------------------
+// ExecImage::FillPage
+// 	If page "virtPage" of the image is cached, copy it into "frame"
+//	and say what kind of fault first loaded it.
+//----------------------------------------------------------------------
+
+bool
+ExecImage::FillPage(int virtPage, char *frame, VMFaultType *type)
+{
+    if (virtPage < 0 || virtPage >= ExecHotPages || !hotValid[virtPage])
+	return FALSE;
+    bcopy(&hot[virtPage * PageSize], frame, PageSize);
+    *type = hotType[virtPage];
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ExecImage::SavePage
+// 	Keep a copy of a page just built from the executable, before the
+//	program has had a chance to change it.
+//----------------------------------------------------------------------
+
+void
+ExecImage::SavePage(int virtPage, char *frame, VMFaultType type)
+{
+    if (virtPage < 0 || virtPage >= ExecHotPages || hotValid[virtPage])
+	return;
+    bcopy(frame, &hot[virtPage * PageSize], PageSize);
+    hotType[virtPage] = type;
+    hotValid[virtPage] = TRUE;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::ExecCache
+// 	Initialize an empty cache.
+//----------------------------------------------------------------------
+
+ExecCache::ExecCache()
+{
+    for (int i = 0; i < ExecCacheSize; i++)
+	images[i] = NULL;
+    clock = hits = misses = 0;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::~ExecCache
+// 	Throw away every cached image.  Only called as Nachos halts.
+//----------------------------------------------------------------------
+
+ExecCache::~ExecCache()
+{
+    DEBUG('u', "Exec cache: %d hits, %d misses\n", hits, misses);
+    for (int i = 0; i < ExecCacheSize; i++)
+	if (images[i] != NULL)
+	    delete images[i];
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Drop
+// 	Take the image in "slot" out of the table.  It is deleted now if
+//	nobody is running it, and otherwise by the last Put.  Called with
+//	interrupts off.
+//----------------------------------------------------------------------
+
+void
+ExecCache::Drop(int slot)
+{
+    ExecImage *image = images[slot];
+
+    images[slot] = NULL;
+    image->stale = TRUE;
+    if (image->refs == 0)
+	delete image;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Get
+// 	Return the image of executable "name", with a reference held for
+//	the caller.  On a miss, open the file and read its header, then
+//	enter it in the table in place of the least recently used image.
+//----------------------------------------------------------------------
+
+ExecImage *
+ExecCache::Get(char *name)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    ExecImage *image = NULL;
+    OpenFile *executable;
+    NoffHeader noffH;
+    int i, victim;
+
+    clock++;
+    for (i = 0; i < ExecCacheSize; i++)
+	if (images[i] != NULL && strcmp(images[i]->name, name) == 0) {
+	    image = images[i];
+	    image->refs++;
+	    image->lastUse = clock;
+	    hits++;
+	    (void) interrupt->SetLevel(oldLevel);
+	    return image;
+	}
+    misses++;
+    (void) interrupt->SetLevel(oldLevel);
+
+    // not cached: read the header, with interrupts back on
+    executable = fileSystem->Open(name);
+    if (executable == NULL)
+	return NULL;
+    executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
+    if ((noffH.noffMagic != NOFFMAGIC) &&
+            (WordToHost(noffH.noffMagic) == NOFFMAGIC))
+        SwapHeader(&noffH);
+    if (noffH.noffMagic != NOFFMAGIC) {
+        DEBUG('u', "Attemted to execute non-noff executable \"%s\".\n", name);
+	delete executable;
+	return NULL;
+    }
+    image = new ExecImage(name, executable, &noffH);
+    image->refs = 1;
+    image->lastUse = clock;
+
+    // replace the oldest image nobody is running, if the table is full;
+    // if every one is in use, this image just isn't kept
+    oldLevel = interrupt->SetLevel(IntOff);
+    for (i = 0; i < ExecCacheSize; i++)
+	if (images[i] != NULL && strcmp(images[i]->name, name) == 0) {
+	    // somebody else loaded it while we were reading
+	    delete image;
+	    image = images[i];
+	    image->refs++;
+	    image->lastUse = clock;
+	    (void) interrupt->SetLevel(oldLevel);
+	    return image;
+	}
+    victim = -1;
+    for (i = 0; i < ExecCacheSize; i++) {
+	if (images[i] == NULL) {
+	    victim = i;
+	    break;
+	}
+	if (images[i]->refs == 0 && 
+		(victim == -1 || images[i]->lastUse < images[victim]->lastUse))
+	    victim = i;
+    }
+    if (victim == -1)
+	image->stale = TRUE;
+    else {
+	if (images[victim] != NULL)
+	    Drop(victim);
+	images[victim] = image;
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    return image;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Hold
+// 	Take another reference on an image we already hold, for a copy
+//	of an address space.
+//----------------------------------------------------------------------
+
+void
+ExecCache::Hold(ExecImage *image)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(image->refs > 0);
+    image->refs++;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Put
+// 	Release a reference taken by Get or Hold.  Safe to call from 
+//	~AddrSpace.
+//----------------------------------------------------------------------
+
+void
+ExecCache::Put(ExecImage *image)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(image->refs > 0);
+    image->refs--;
+    if (image->stale && image->refs == 0)
+	delete image;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Invalidate
+// 	Forget any image of "name"; the file is about to change.
+//----------------------------------------------------------------------
+
+void
+ExecCache::Invalidate(char *name)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    for (int i = 0; i < ExecCacheSize; i++)
+	if (images[i] != NULL && strcmp(images[i]->name, name) == 0) {
+	    DEBUG('u', "Exec cache: dropping \"%s\"\n", name);
+	    Drop(i);
+	}
+    (void) interrupt->SetLevel(oldLevel);
+}
@@ -0,0 +1,80 @@
+// execcache.h 
+//	Data structures for caching executables across Exec calls.
+//
+//	Every Exec used to open the executable, read and byte-swap its
+//	NOFF header and close it again, and then every page fault on
+//	code or data opened it once more.  Shells and fan-out programs
+//	start the same few binaries over and over, so the kernel keeps
+//	the last few executables it has run: the parsed header, the size
+//	of the address space, the open file for demand paging, and a copy
+//	of the first few pages exactly as they are first loaded.
+//
+//	An entry is keyed by file name and must be thrown away when that
+//	file is re-created (see Invalidate).  Address spaces hold a
+//	reference to their image, so an image that is invalidated while
+//	programs are still running from it stays around, unchanged, until
+//	the last of them goes away.
+//
+//	The table is only touched with interrupts off, since images are
+//	released from ~AddrSpace, which runs inside Scheduler::Run.
+
+#ifndef EXECCACHE_H
+#define EXECCACHE_H
+
+#include "copyright.h"
+#include "addrspace.h"		// noff.h can only be included once
+
+#define ExecCacheSize	8	// executables kept
+#define ExecHotPages	4	// leading pages of each kept in memory
+
+// The following class defines one cached executable.
+
+class ExecImage {
+  public:
+    ExecImage(char *fileName, OpenFile *executable, NoffHeader *hdr);
+    ~ExecImage();
+
+    bool FillPage(int virtPage, char *frame, VMFaultType *type);
+					// copy a cached page into "frame";
+					// FALSE if it is not cached
+    void SavePage(int virtPage, char *frame, VMFaultType type);
+					// remember a freshly loaded page
+
+    char *name;
+    OpenFile *file;			// kept open, for demand paging
+    NoffHeader noffH;			// already in host byte order
+    int numPages;			// size of the address space it needs
+
+  private:
+    friend class ExecCache;
+
+    int refs;				// address spaces using this image
+    bool stale;				// no longer in the table
+    int lastUse;			// for replacement
+    char *hot;				// the first ExecHotPages pages
+    bool hotValid[ExecHotPages];
+    VMFaultType hotType[ExecHotPages];	// what kind of fault loaded it
+};
+
+// The following class defines the cache itself.
+
+class ExecCache {
+  public:
+    ExecCache();
+    ~ExecCache();
+
+    ExecImage *Get(char *name);		// find or load "name"; NULL if it 
+					// can't be opened or isn't NOFF
+    void Hold(ExecImage *image);	// take another reference
+    void Put(ExecImage *image);		// drop a reference
+    void Invalidate(char *name);	// "name" is being re-created
+
+  private:
+    void Drop(int slot);		// take an image out of the table
+
+    ExecImage *images[ExecCacheSize];
+    int clock;				// counts lookups, for lastUse
+    int hits, misses;
+};
+
+#endif // EXECCACHE_H
@@ -3,28 +3,43 @@
  * Contains the information about open files that
  * a process has.
  *
+ * Each fd is a slot pointing at an entry of the system-wide
+ * open-file table (see filetable.h), which says whether it is
+ * the console, an OpenFile or one end of a Pipe. Slots grow
+ * as needed, and a new fd is always the lowest free one; a
+ * hint of where that is keeps the search short.
+ *
  * See addrspace.cc for implementation.
  */
 
 #ifndef FD_LIST_H
 #define FD_LIST_H
 
-#include "bitmap.h"
+#include "filetable.h"
+
+#define InitialFDSlots	16	// fd slots a process starts with
+#define MaxFDSlots	1024	// most fds a process can have open
 
 class Lock;
 class FD_List
 {
-	BitMap map;
-	void **list;
+	OpenFileEntry **slots;
+	int size;	// slots allocated
+	int lowest;	// no slot below this one is free
 	Lock *lock;
-	int size;
+	bool grow( int );
+	int install( OpenFileEntry* );
 public:
 	FD_List();
-	FD_List( int );
 	~FD_List();
+	OpenFileEntry *fd_entry( int );
 	void *fd_get( int );
-	int fd_put( void* );
-	void *fd_remove( int );
+	FDType fd_type( int );
+	int fd_put( void*, FDType type = FD_FILE );
+	int fd_dup( int );
+	bool fd_put_at( int, OpenFileEntry* );
+	OpenFileEntry *fd_remove( int );
+	int fd_size() { return size; }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,161 @@
+// filetable.cc 
+//	Routines to keep track of the files and pipe ends that user
+//	programs have open, and of how many fds refer to each.
+//
+//	The table is only changed with its lock held; closing what an
+//	entry refers to is done after letting the lock go, since it may
+//	wait for asynchronous I/O on the file to finish.
+
+#include "copyright.h"
+#include "system.h"
+#include "filetable.h"
+#include "synch.h"
+#include "openfile.h"
+#include "pipe.h"
+#include "aio.h"
+
+//----------------------------------------------------------------------
+// OpenFileEntry::OpenFileEntry
+// 	Make an entry for "obj", with one reference.
+//----------------------------------------------------------------------
+
+OpenFileEntry::OpenFileEntry(FDType t, void *obj)
+{
+    type = t;
+    object = obj;
+    refs = 1;
+    prev = next = NULL;
+}
+
+//----------------------------------------------------------------------
+// FileTable::FileTable
+// 	Initialize an empty open-file table.
+//----------------------------------------------------------------------
+
+FileTable::FileTable()
+{
+    entries = NULL;
+    numOpen = 0;
+    lock = new Lock("file table");
+}
+
+//----------------------------------------------------------------------
+// FileTable::~FileTable
+// 	De-allocate the table.  Entries still open belong to processes
+//	that never finished, and are left alone.
+//----------------------------------------------------------------------
+
+FileTable::~FileTable()
+{
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Open
+// 	Enter "object" in the table, and return the entry, with one
+//	reference for the fd it is about to be put in.  A pipe end is
+//	opened here, once per entry, however many fds come to share it.
+//----------------------------------------------------------------------
+
+OpenFileEntry *
+FileTable::Open(FDType type, void *object)
+{
+    OpenFileEntry *entry = new OpenFileEntry(type, object);
+
+    if (type == FD_PIPE_READ || type == FD_PIPE_WRITE)
+	((PipeBuffer *) object)->Open(type == FD_PIPE_WRITE);
+
+    lock->Acquire();
+    entry->next = entries;
+    if (entries != NULL)
+	entries->prev = entry;
+    entries = entry;
+    numOpen++;
+    lock->Release();
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Hold
+// 	Note that one more fd refers to "entry", after Dup or Exec.
+//----------------------------------------------------------------------
+
+void
+FileTable::Hold(OpenFileEntry *entry)
+{
+    lock->Acquire();
+    ASSERT(entry->refs > 0);
+    entry->refs++;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// FileTable::Release
+// 	Note that an fd referring to "entry" was closed.  When it was 
+//	the last one, take the entry out of the table and close what it
+//	refers to.
+//----------------------------------------------------------------------
+
+void
+FileTable::Release(OpenFileEntry *entry)
+{
+    lock->Acquire();
+    ASSERT(entry->refs > 0);
+    if (--entry->refs > 0) {
+	lock->Release();
+	return;
+    }
+    if (entry->prev != NULL)
+	entry->prev->next = entry->next;
+    else
+	entries = entry->next;
+    if (entry->next != NULL)
+	entry->next->prev = entry->prev;
+    numOpen--;
+    lock->Release();
+
+    Close(entry);
+    delete entry;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Close
+// 	Close the file or pipe end behind "entry", now that no fd refers
+//	to it.  The I/O thread may still be using a file, on behalf of
+//	any process that shared it, so wait for that first.
+//----------------------------------------------------------------------
+
+void
+FileTable::Close(OpenFileEntry *entry)
+{
+    switch (entry->type) {
+      case FD_FILE:
+	aioManager->Drain(NULL, (OpenFile *) entry->object);
+	delete (OpenFile *) entry->object;
+	break;
+      case FD_PIPE_READ:
+      case FD_PIPE_WRITE:
+	((PipeBuffer *) entry->object)->Close(entry->type == FD_PIPE_WRITE);
+	break;
+      default:			// the console stays open
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// FileTable::Print
+// 	Print the open entries, for debugging.
+//----------------------------------------------------------------------
+
+void
+FileTable::Print()
+{
+    static const char *typeNames[] = { "none", "console in", "console out", 
+				       "file", "pipe read", "pipe write" };
+
+    lock->Acquire();
+    printf("Open-file table, %d entries:\n", numOpen);
+    for (OpenFileEntry *e = entries; e != NULL; e = e->next)
+	printf("\t%s %p, %d refs\n", typeNames[e->type], e->object, e->refs);
+    lock->Release();
+}
@@ -0,0 +1,62 @@
+// filetable.h 
+//	Data structures for the system-wide open-file table.
+//
+//	Opening a file, or either end of a pipe, makes an entry in this
+//	table.  A process refers to entries through the slots of its own
+//	fd table (see fd_list.h); several slots, in one process or in
+//	several, can refer to the same entry, after Dup or Exec.  They
+//	then share it, and its position in the file, just as in UNIX.
+//
+//	Each entry counts the fd slots that refer to it, and the file is
+//	closed (or the pipe end let go) only when the last of them is.
+
+#ifndef FILETABLE_H
+#define FILETABLE_H
+
+#include "copyright.h"
+
+class Lock;
+
+// what an entry refers to
+enum FDType { FD_NONE, FD_CONSOLE_IN, FD_CONSOLE_OUT, FD_FILE, 
+	      FD_PIPE_READ, FD_PIPE_WRITE };
+
+// The following class defines one open file, pipe end, or console
+// stream.
+
+class OpenFileEntry {
+  public:
+    OpenFileEntry(FDType t, void *obj);
+
+    FDType type;
+    void *object;		// OpenFile or PipeBuffer; NULL for the console
+    int refs;			// fd slots that refer to this entry
+    OpenFileEntry *prev, *next;	// on the table's list
+};
+
+// The following class defines the open-file table.
+
+class FileTable {
+  public:
+    FileTable();
+    ~FileTable();
+
+    OpenFileEntry *Open(FDType type, void *object);
+				// make an entry with one reference, taking
+				// over "object"
+    void Hold(OpenFileEntry *entry);	// one more fd refers to "entry"
+    void Release(OpenFileEntry *entry);	// one fewer; closes the object
+				// when none are left
+
+    int NumOpen() { return numOpen; }
+    void Print();		// list the entries, for debugging
+
+  private:
+    void Close(OpenFileEntry *entry);	// close the object behind it
+
+    OpenFileEntry *entries;	// every open entry
+    int numOpen;
+    Lock *lock;
+};
+
+#endif // FILETABLE_H
@@ -0,0 +1,155 @@
+// futex.cc 
+//	Routines to put threads to sleep on a word of user memory, and to
+//	wake them up again.
+
+#include "copyright.h"
+#include "system.h"
+#include "futex.h"
+
+//----------------------------------------------------------------------
+// FutexTable::FutexTable
+// 	Initialize a table with nobody waiting.
+//----------------------------------------------------------------------
+
+FutexTable::FutexTable()
+{
+    for (int i = 0; i < FutexBuckets; i++)
+	buckets[i] = NULL;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::~FutexTable
+// 	Throw away the queues of words still being waited on.
+//----------------------------------------------------------------------
+
+FutexTable::~FutexTable()
+{
+    for (int i = 0; i < FutexBuckets; i++) {
+	while (buckets[i] != NULL) {
+	    FutexQueue *queue = buckets[i];
+
+	    buckets[i] = queue->hashNext;
+	    delete queue;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Resolve
+// 	Return where the word at virtual address "addr" in "space" is in
+//	mainMemory, paging it in if it is out; -1 if "addr" is not a word
+//	of the program.  Called with interrupts off, so the page cannot
+//	be stolen again once this returns, though it may sleep on the
+//	disk meanwhile.
+//----------------------------------------------------------------------
+
+int
+FutexTable::Resolve(AddrSpace *space, int addr)
+{
+    char *word;
+
+    if (addr % 4 != 0 || (word = space->frame_addr(addr, FALSE)) == NULL)
+	return -1;
+    return word - machine->mainMemory;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Find
+// 	Return the link that points to the queue for "paddr", or the
+//	NULL link at the end of its bucket if nobody waits there.
+//----------------------------------------------------------------------
+
+FutexQueue **
+FutexTable::Find(int paddr)
+{
+    FutexQueue **link = &buckets[(paddr / 4) % FutexBuckets];
+
+    while (*link != NULL && (*link)->paddr != paddr)
+	link = &(*link)->hashNext;
+    return link;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wait
+// 	Put the current thread to sleep on the word at "addr", unless
+//	it no longer holds "expected" -- some other thread changed it
+//	between the caller's look at it and the trap, so the caller
+//	should look again rather than wait for a wakeup that already
+//	happened.
+//
+//	The first waiter on a word holds its frame, so that the word
+//	stays where the table says it is.
+//
+// Returns:
+//	0 once woken, -1 if the word was not "expected" or "addr" is bad
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wait(AddrSpace *space, int addr, int expected)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int paddr = Resolve(space, addr);
+    FutexQueue **link;
+
+    if (paddr == -1 
+	    || (int) WordToHost(*(unsigned int *) 
+			&(machine->mainMemory[paddr])) != expected) {
+	(void) interrupt->SetLevel(oldLevel);
+	return -1;
+    }
+    link = Find(paddr);
+    if (*link == NULL) {
+	*link = new FutexQueue;
+	(*link)->paddr = paddr;
+	(*link)->hashNext = NULL;
+	HoldFrame(paddr / PageSize);
+    }
+    DEBUG('t', "Thread \"%s\" waits on futex 0x%x\n", 
+	currentThread->getName(), addr);
+    (*link)->waiters.Append(currentThread);
+    scheduler->Blocked(currentThread);
+    currentThread->Sleep();
+    (void) interrupt->SetLevel(oldLevel);
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wake
+// 	Wake up to "count" of the threads waiting on the word at "addr",
+//	oldest first.  When the last one goes, so does the queue, and
+//	the hold on the frame.
+//
+// Returns:
+//	the number of threads woken, or -1 if "addr" is bad
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wake(AddrSpace *space, int addr, int count)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int paddr = Resolve(space, addr);
+    FutexQueue **link, *queue;
+    Thread *thread;
+    int woken = 0;
+
+    if (paddr == -1) {
+	(void) interrupt->SetLevel(oldLevel);
+	return -1;
+    }
+    link = Find(paddr);
+    queue = *link;
+    if (queue != NULL) {
+	while (woken < count && (thread = queue->waiters.Remove()) != NULL) {
+	    scheduler->ReadyToRun(thread);
+	    woken++;
+	}
+	if (queue->waiters.IsEmpty()) {
+	    *link = queue->hashNext;
+	    delete queue;
+	    ReleaseFrame(paddr / PageSize);
+	}
+    }
+    DEBUG('t', "Woke %d threads on futex 0x%x\n", woken, addr);
+    (void) interrupt->SetLevel(oldLevel);
+    return woken;
+}
@@ -0,0 +1,64 @@
+// futex.h 
+//	Data structures for the FutexWait and FutexWake system calls.
+//
+//	A futex is just a word of user memory.  User code does the
+//	uncontended case on its own, with an atomic CompareAndSwap (see
+//	start.s); only when it has to wait, or has waiters to wake, does
+//	it trap.  FutexWait puts the caller to sleep if the word still
+//	holds the value it expects, and FutexWake wakes up to "count" of
+//	the threads waiting on the word.
+//
+//	Waiters are found by the physical address of the word, hashed,
+//	so threads of different processes meet on a word of a shared
+//	memory segment just as threads of one process do.  While anybody
+//	waits on a word its frame is held (see HoldFrame in addrspace.h)
+//	so it is never paged out and the address stays good.
+//
+//	The table is only touched with interrupts off, which also makes
+//	checking the word and going to sleep atomic.
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "copyright.h"
+#include "thread.h"
+#include "waitqueue.h"
+
+class AddrSpace;
+
+#define FutexBuckets	31	// hash buckets, by physical address
+
+// The following class defines the threads waiting on one word.
+
+class FutexQueue {
+  public:
+    int paddr;				// the word, in mainMemory
+    WaitQueue<Thread> waiters;
+    FutexQueue *hashNext;		// next in this hash bucket
+};
+
+// The following class defines the table of words being waited on.
+
+class FutexTable {
+  public:
+    FutexTable();
+    ~FutexTable();
+
+    int Wait(AddrSpace *space, int addr, int expected);
+					// sleep until woken, if the word at
+					// "addr" is "expected"; -1 if it
+					// isn't, or "addr" is bad
+    int Wake(AddrSpace *space, int addr, int count);
+					// wake up to "count" waiters on
+					// "addr"; returns how many, or -1
+
+  private:
+    int Resolve(AddrSpace *space, int addr);
+					// physical address of the word,
+					// paged in; -1 if bad
+    FutexQueue **Find(int paddr);	// where its queue is, or belongs
+
+    FutexQueue *buckets[FutexBuckets];
+};
+
+#endif // FUTEX_H
@@ -0,0 +1,170 @@
+// pipe.cc 
+//	Routines to read, write and close pipes.
+
+#include "copyright.h"
+#include "system.h"
+#include "pipe.h"
+
+//----------------------------------------------------------------------
+// PipeBuffer::PipeBuffer
+// 	Initialize an empty pipe, with neither end open yet.
+//----------------------------------------------------------------------
+
+PipeBuffer::PipeBuffer()
+{
+    head = count = 0;
+    readers = writers = 0;
+    lock = new Lock("pipe lock");
+    dataReady = new Condition("pipe data");
+    roomReady = new Condition("pipe room");
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::~PipeBuffer
+// 	De-allocate a pipe, once both ends are closed.
+//----------------------------------------------------------------------
+
+PipeBuffer::~PipeBuffer()
+{
+    delete lock;
+    delete dataReady;
+    delete roomReady;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Transfer
+// 	Copy "size" bytes between the ring, starting at ring position
+//	"pos", and user memory at "addr", in pieces that neither wrap
+//	around the ring nor cross a page.  Called with the lock held.
+//
+//	Returns the number of bytes copied, which is short only if the
+//	user address is bad.
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Transfer(AddrSpace *space, int addr, int pos, int size, bool toUser)
+{
+    int done = 0;
+
+    while (done < size) {
+	int chunk = size - done;
+	int ring = (pos + done) % PipeSize;
+	char *frame;
+
+	if (chunk > PipeSize - ring)
+	    chunk = PipeSize - ring;
+	if (chunk > PageSize - (addr + done) % PageSize)
+	    chunk = PageSize - (addr + done) % PageSize;
+	if ((frame = space->frame_addr(addr + done, toUser)) == NULL)
+	    break;
+	if (toUser)
+	    bcopy(&buffer[ring], frame, chunk);
+	else
+	    bcopy(frame, &buffer[ring], chunk);
+	done += chunk;
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Read
+// 	Wait until there is something in the pipe, or no writer is left,
+//	then copy out as much as is there, up to "size" bytes.
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Read(AddrSpace *space, int addr, int size)
+{
+    int n;
+
+    lock->Acquire();
+    while (count == 0 && writers > 0)
+	dataReady->Wait(lock);
+    n = (size < count) ? size : count;
+    n = Transfer(space, addr, head, n, TRUE);
+    head = (head + n) % PipeSize;
+    count -= n;
+    if (n > 0)
+	roomReady->Broadcast(lock);
+    lock->Release();
+    return n;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Write
+// 	Copy "size" bytes into the pipe, waiting whenever it is full.
+//	Gives up if every read end is closed, returning what got in, or
+//	-1 if nothing did.
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Write(AddrSpace *space, int addr, int size)
+{
+    int done = 0;
+
+    lock->Acquire();
+    while (done < size) {
+	int n;
+
+	while (count == PipeSize && readers > 0)
+	    roomReady->Wait(lock);
+	if (readers == 0)
+	    break;
+	n = size - done;
+	if (n > PipeSize - count)
+	    n = PipeSize - count;
+	n = Transfer(space, addr + done, head + count, n, FALSE);
+	if (n == 0)
+	    break;			// bad user address
+	count += n;
+	done += n;
+	dataReady->Broadcast(lock);
+    }
+    lock->Release();
+    return (done > 0 || size == 0) ? done : -1;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Open
+// 	Count another fd on the read or write end.
+//----------------------------------------------------------------------
+
+void
+PipeBuffer::Open(bool writeEnd)
+{
+    lock->Acquire();
+    if (writeEnd)
+	writers++;
+    else
+	readers++;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Close
+// 	Drop an fd on the read or write end.  When the last writer goes,
+//	waiting readers see end of file; when the last reader goes,
+//	waiting writers give up.  When both ends are gone, so is the pipe.
+//----------------------------------------------------------------------
+
+void
+PipeBuffer::Close(bool writeEnd)
+{
+    bool unused;
+
+    lock->Acquire();
+    if (writeEnd) {
+	ASSERT(writers > 0);
+	if (--writers == 0)
+	    dataReady->Broadcast(lock);
+    } else {
+	ASSERT(readers > 0);
+	if (--readers == 0)
+	    roomReady->Broadcast(lock);
+    }
+    unused = (readers == 0 && writers == 0);
+    lock->Release();
+
+    if (unused)
+	delete this;
+}
@@ -0,0 +1,58 @@
+// pipe.h 
+//	Data structures for pipes between user programs.
+//
+//	A pipe is a bounded ring buffer in the kernel with a read end and
+//	a write end, each of which can be open in several processes (a
+//	pipe end is inherited across Exec).  Readers wait while the pipe
+//	is empty and writers wait while it is full, on condition
+//	variables; a read of an empty pipe with no writers left returns
+//	0 (end of file), and a write with no readers left fails.
+//
+//	Bytes move straight between the ring and the user's frames, so
+//	data sent through a pipe never touches the disk.
+
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "copyright.h"
+#include "synch.h"
+
+class AddrSpace;
+
+#define PipeSize	512	// bytes buffered in a pipe
+
+// The following class defines a pipe.  (It is not called Pipe, which
+// is the name of the system call in syscall.h.)
+
+class PipeBuffer {
+  public:
+    PipeBuffer();
+    ~PipeBuffer();
+
+    int Read(AddrSpace *space, int addr, int size);
+				// read at most "size" bytes into user memory,
+				// waiting for at least one; 0 at end of file
+    int Write(AddrSpace *space, int addr, int size);
+				// write all "size" bytes from user memory,
+				// waiting for room; -1 if nobody can read them
+
+    void Open(bool writeEnd);	// one more open-file entry refers to an end
+    void Close(bool writeEnd);	// one fewer; the pipe deletes itself
+				// when neither end is open
+
+  private:
+    int Transfer(AddrSpace *space, int addr, int pos, int size, 
+		bool toUser);	// copy between the ring and user memory
+
+    char buffer[PipeSize];	// the ring
+    int head;			// where the next byte is read from
+    int count;			// bytes in the ring
+    int readers, writers;	// open-file entries on each end
+    Lock *lock;
+    Condition *dataReady;	// signalled when bytes arrive, or the
+				// last writer goes away
+    Condition *roomReady;	// signalled when bytes are taken, or the
+				// last reader goes away
+};
+
+#endif // PIPE_H
@@ -0,0 +1,336 @@
+// proctable.cc 
+//	Routines to add processes, record their exit, and wait for them.
+
+#include "copyright.h"
+#include "system.h"
+#include "proctable.h"
+
+//----------------------------------------------------------------------
+// Process::Process
+// 	Initialize the record of a process that is just starting, and
+//	add it to its parent's children.
+//----------------------------------------------------------------------
+
+Process::Process(int id, Thread *t, Process *parentProc)
+{
+    pid = id;
+    thread = t;
+    exited = FALSE;
+    status = -1;
+    parent = parentProc;
+    children = NULL;
+    prevSibling = NULL;
+    nextSibling = NULL;
+    childExited = new Condition("child exited");
+    hashNext = NULL;
+
+    if (parentProc != NULL)
+	Link(parentProc);
+}
+
+//----------------------------------------------------------------------
+// Process::~Process
+// 	De-allocate a record, taking it off its parent's children.
+//----------------------------------------------------------------------
+
+Process::~Process()
+{
+    Unlink();
+    delete childExited;
+}
+
+//----------------------------------------------------------------------
+// Process::Link
+// 	Make this the first of "parentProc"'s children.
+//----------------------------------------------------------------------
+
+void
+Process::Link(Process *parentProc)
+{
+    parent = parentProc;
+    prevSibling = NULL;
+    nextSibling = parent->children;
+    if (nextSibling != NULL)
+	nextSibling->prevSibling = this;
+    parent->children = this;
+}
+
+//----------------------------------------------------------------------
+// Process::Unlink
+// 	Take this off its parent's children, if it has a parent.
+//----------------------------------------------------------------------
+
+void
+Process::Unlink()
+{
+    if (parent == NULL)
+	return;
+    if (prevSibling != NULL)
+	prevSibling->nextSibling = nextSibling;
+    else
+	parent->children = nextSibling;
+    if (nextSibling != NULL)
+	nextSibling->prevSibling = prevSibling;
+    parent = NULL;
+    prevSibling = nextSibling = NULL;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::ProcessTable
+// 	Initialize an empty table.
+//----------------------------------------------------------------------
+
+ProcessTable::ProcessTable()
+{
+    numBuckets = InitialProcBuckets;
+    buckets = new Process *[numBuckets];
+    for (int i = 0; i < numBuckets; i++)
+	buckets[i] = NULL;
+    numProcs = 0;
+    nextPid = 0;
+    lock = new Lock("process table");
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::~ProcessTable
+// 	De-allocate the table and every record left in it.
+//----------------------------------------------------------------------
+
+ProcessTable::~ProcessTable()
+{
+    for (int i = 0; i < numBuckets; i++)
+	while (buckets[i] != NULL) {
+	    Process *proc = buckets[i];
+	    buckets[i] = proc->hashNext;
+	    proc->parent = NULL;	// its siblings may be gone already
+	    delete proc;
+	}
+    delete [] buckets;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Lookup
+// 	Return the record of process "pid", or NULL.  Pids are handed
+//	out in order, so taking them modulo the number of buckets spreads
+//	them evenly.
+//----------------------------------------------------------------------
+
+Process *
+ProcessTable::Lookup(int pid)
+{
+    Process *proc;
+
+    if (pid < 0)
+	return NULL;
+    for (proc = buckets[pid % numBuckets]; proc != NULL; proc = proc->hashNext)
+	if (proc->pid == pid)
+	    return proc;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Insert
+// 	Put a record in its hash bucket, growing the table first if the
+//	chains would get long.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Insert(Process *proc)
+{
+    if (numProcs >= 2 * numBuckets)
+	Grow();
+    proc->hashNext = buckets[proc->pid % numBuckets];
+    buckets[proc->pid % numBuckets] = proc;
+    numProcs++;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Grow
+// 	Double the number of buckets and rehash every record.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Grow()
+{
+    Process **old = buckets;
+    int oldBuckets = numBuckets;
+
+    numBuckets *= 2;
+    buckets = new Process *[numBuckets];
+    for (int i = 0; i < numBuckets; i++)
+	buckets[i] = NULL;
+    for (int i = 0; i < oldBuckets; i++)
+	while (old[i] != NULL) {
+	    Process *proc = old[i];
+	    old[i] = proc->hashNext;
+	    proc->hashNext = buckets[proc->pid % numBuckets];
+	    buckets[proc->pid % numBuckets] = proc;
+	}
+    delete [] old;
+    DEBUG('t', "Process table grown to %d buckets\n", numBuckets);
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Remove
+// 	Take a record out of the table for good.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Remove(Process *proc)
+{
+    Process **link = &buckets[proc->pid % numBuckets];
+
+    while (*link != proc)
+	link = &(*link)->hashNext;
+    *link = proc->hashNext;
+    numProcs--;
+    delete proc;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Add
+// 	Make a record for a process about to run in "thread".
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Add(Thread *thread, int parentPid)
+{
+    Process *proc;
+
+    lock->Acquire();
+    proc = new Process(nextPid++, thread, Lookup(parentPid));
+    Insert(proc);
+    lock->Release();
+    return proc->pid;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Discard
+// 	Forget process "pid", which could not be started, without its 
+//	parent ever seeing it exit.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Discard(int pid)
+{
+    Process *proc;
+
+    lock->Acquire();
+    proc = Lookup(pid);
+    if (proc != NULL) {
+	ASSERT(proc->children == NULL);
+	Remove(proc);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Exit
+// 	Record the exit status of "pid".  Its exited children go away,
+//	the rest are orphaned.  If it is an orphan itself nobody will
+//	ever ask for the status, so it goes away too; otherwise its
+//	parent is woken.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Exit(int pid, int status)
+{
+    Process *proc;
+
+    lock->Acquire();
+    proc = Lookup(pid);
+    if (proc == NULL || proc->exited) {
+	lock->Release();
+	return;
+    }
+    while (proc->children != NULL) {
+	Process *child = proc->children;
+	child->Unlink();
+	if (child->exited)
+	    Remove(child);
+    }
+    proc->exited = TRUE;
+    proc->status = status;
+    proc->thread = NULL;
+    if (proc->parent == NULL)
+	Remove(proc);
+    else {
+	Process *parent = proc->parent;
+
+	proc->Unlink();			// exited children go first
+	proc->Link(parent);
+	parent->childExited->Broadcast(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Join
+// 	Wait for child "pid" of "parentPid" to exit, hand back its status
+//	and forget it.  Returns -1 if "pid" isn't (or is no longer) a 
+//	child of "parentPid".
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Join(int parentPid, int pid, int *status)
+{
+    Process *parent, *child;
+
+    lock->Acquire();
+    parent = Lookup(parentPid);
+    for (;;) {
+	// look again after every wait: another thread of the parent may
+	// have reaped it meanwhile
+	child = Lookup(pid);
+	if (parent == NULL || child == NULL || child->parent != parent) {
+	    lock->Release();
+	    return -1;
+	}
+	if (child->exited)
+	    break;
+	parent->childExited->Wait(lock);
+    }
+    *status = child->status;
+    Remove(child);
+    lock->Release();
+    return pid;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::WaitAny
+// 	Wait for whichever child of "parentPid" exits first (or has
+//	already exited), hand back its status, forget it, and return its
+//	pid.  Returns -1 if there are no children to wait for.
+//
+//	Exit moves a child to the front as it exits, but a child started
+//	since then is linked in ahead of it, so every child is looked at.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::WaitAny(int parentPid, int *status)
+{
+    Process *parent, *child;
+    int pid;
+
+    lock->Acquire();
+    parent = Lookup(parentPid);
+    for (;;) {
+	if (parent == NULL || parent->children == NULL) {
+	    lock->Release();
+	    return -1;
+	}
+	for (child = parent->children; child != NULL; 
+		child = child->nextSibling)
+	    if (child->exited)
+		break;
+	if (child != NULL)
+	    break;
+	parent->childExited->Wait(lock);
+    }
+    pid = child->pid;
+    *status = child->status;
+    Remove(child);
+    lock->Release();
+    return pid;
+}
@@ -0,0 +1,86 @@
+// proctable.h 
+//	Data structures to keep track of user processes: who is running,
+//	who started them, and how they exited.
+//
+//	Every process gets a record, found by pid through a hash table
+//	that doubles whenever it gets crowded, so lookups take constant
+//	time however many processes there are.  Each record keeps its
+//	children on a doubly linked list, so adding or reaping a child
+//	is also constant time.  A child that exits moves to the head of
+//	that list, so WaitAny finds one without searching.
+//
+//	A record outlives its process until the parent has collected
+//	the exit status with Join or WaitAny.  When the parent exits
+//	first, its children are orphaned, and their records are freed as
+//	soon as they exit.
+
+#ifndef PROCTABLE_H
+#define PROCTABLE_H
+
+#include "copyright.h"
+#include "synch.h"
+
+class Thread;
+
+#define InitialProcBuckets	16	// hash buckets to start with
+
+// The following class defines one process.
+
+class Process {
+  public:
+    Process(int id, Thread *t, Process *parentProc);
+    ~Process();
+
+    void Link(Process *parentProc);	// put at the head of its children
+    void Unlink();			// take off its parent's children
+
+    int pid;
+    Thread *thread;		// NULL once it has exited
+    bool exited;
+    int status;			// the exit status, once exited
+
+    Process *parent;		// NULL if orphaned
+    Process *children;		// first child not yet reaped
+    Process *prevSibling, *nextSibling;
+    Condition *childExited;	// waited on in Join/WaitAny
+
+    Process *hashNext;		// next in this hash bucket
+};
+
+// The following class defines the table of all processes.
+
+class ProcessTable {
+  public:
+    ProcessTable();
+    ~ProcessTable();
+
+    int Add(Thread *thread, int parentPid);
+				// make a record for a new process, and 
+				// return its pid; "parentPid" is -1 for a 
+				// process nobody will wait for
+    void Discard(int pid);	// forget a process that never ran
+    void Exit(int pid, int status);
+				// record that "pid" exited, and wake its
+				// parent if it is waiting
+    int Join(int parentPid, int pid, int *status);
+				// wait for child "pid" to exit and reap
+				// it; -1 if it is not a child of "parentPid"
+    int WaitAny(int parentPid, int *status);
+				// wait for any child to exit and reap it,
+				// returning its pid; -1 if there are none
+
+  private:
+    Process *Lookup(int pid);	// find the record, or NULL
+    void Insert(Process *proc);
+    void Remove(Process *proc);	// unlink from the hash and from its
+				// parent's children, and delete it
+    void Grow();		// double the number of buckets
+
+    Process **buckets;
+    int numBuckets;
+    int numProcs;
+    int nextPid;
+    Lock *lock;			// protects everything above
+};
+
+#endif // PROCTABLE_H
@@ -14,6 +14,7 @@
 #include "addrspace.h"
 #include "synch.h"
 #include "synchconsole.h"
+#include "proctable.h"
 
 //----------------------------------------------------------------------
 // StartProcess
@@ -21,14 +22,6 @@
 //	memory, and jump to it.
 //----------------------------------------------------------------------
 
-static void RoundRobin(int arg)
-{
-	DEBUG('t', "Interrupt in thread [%s]\n", currentThread->getName());
-	interrupt->Schedule(RoundRobin, (int)currentThread, 20, TimerInt);//every 20 has this interruption
-	//do we need to call scheduler?
-	interrupt->YieldOnReturn();
-}
-
 void
 StartProcess(char *filename)
 {
@@ -45,7 +38,8 @@ StartProcess(char *filename)
     delete executable;			// close file*/
     try
     {
-    	currentThread->space = new AddrSpace(filename);
+    	currentThread->pid = processTable->Add(currentThread, -1);
+    	currentThread->space = new AddrSpace(filename, currentThread->pid);
     	//printf("In start: currentThread: %s\n", currentThread->getName());
     }catch (int e)
     {
@@ -53,8 +47,9 @@ StartProcess(char *filename)
     	return;
     }
     
-    interrupt->Schedule(RoundRobin, (int)currentThread, 20, TimerInt);
+    scheduler->StartTimer();		// time-slice the user programs
     
+    currentThread->LoadUserState();			// claim the machine's registers
     currentThread->space->InitRegisters();		// set the initial register values
     currentThread->space->RestoreState();		// load page table register
     machine->Run();			// jump to the user progam
@@ -69,7 +64,7 @@ StartProcess(char *filename)
 static Console *console;
 static Semaphore *readAvail;
 static Semaphore *writeDone;
-static SynchConsole *synchConsole;
+static SynchConsole *testConsole;
 //----------------------------------------------------------------------
 // ConsoleInterruptHandlers
 // 	Wake up the thread that requested the I/O.
@@ -105,11 +100,11 @@ ConsoleTest (char *in, char *out)
 void SynchConsoleTest(char* in, char* out)
 {
 	char ch;
-	synchConsole = new SynchConsole();
+	testConsole = new SynchConsole(in, out);
 	for(;;)
 	{
-		ch = synchConsole->GetChar();
-		synchConsole->PutChar(ch);
+		ch = testConsole->GetChar();
+		testConsole->PutChar(ch);
 		if(ch == 'q')
 			return;
 	}
@@ -0,0 +1,139 @@
+// ring.cc 
+//	Routines to consume a user program's submission ring and fill in
+//	its completion ring.
+//
+//	The ring indices are free-running counters; an index is reduced
+//	modulo the ring size only to find its slot.  The kernel only ever
+//	writes sqHead and cqTail, and the program only ever writes sqTail
+//	and cqHead.
+
+#include "copyright.h"
+#include "system.h"
+#include "syscalltable.h"
+#include "ring.h"
+
+// offsets of the fields of the user's RingCtl
+#define CtlSqHead	0
+#define CtlSqTail	4
+#define CtlCqHead	8
+#define CtlCqTail	12
+
+//----------------------------------------------------------------------
+// Batchable
+// 	Return TRUE if system call "code" may be submitted through a ring.
+//----------------------------------------------------------------------
+
+static bool
+Batchable(int code)
+{
+    switch (code) {
+      case SC_Create:
+      case SC_Open:
+      case SC_Read:
+      case SC_Write:
+      case SC_Close:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// ReadWord, WriteWord
+// 	Fetch or store one word of user memory, straight in its frame.
+//	The rings are word aligned, so a word never spans a page.
+//	Return FALSE on a bad address.
+//----------------------------------------------------------------------
+
+static bool
+ReadWord(AddrSpace *space, int addr, int *value)
+{
+    char *word;
+
+    if (addr % 4 != 0 || (word = space->frame_addr(addr, FALSE)) == NULL)
+	return FALSE;
+    *value = WordToHost(*(unsigned int *) word);
+    return TRUE;
+}
+
+static bool
+WriteWord(AddrSpace *space, int addr, int value)
+{
+    char *word;
+
+    if (addr % 4 != 0 || (word = space->frame_addr(addr, TRUE)) == NULL)
+	return FALSE;
+    *(unsigned int *) word = WordToMachine((unsigned int) value);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SyscallRing::SyscallRing
+// 	Remember where a program's rings are.  RingSetup has already 
+//	checked that "numEntries" is positive.
+//----------------------------------------------------------------------
+
+SyscallRing::SyscallRing(int ctlAddr, int sqAddr, int cqAddr, int numEntries)
+{
+    ctl = ctlAddr;
+    sq = sqAddr;
+    cq = cqAddr;
+    entries = numEntries;
+}
+
+//----------------------------------------------------------------------
+// SyscallRing::Enter
+// 	Consume up to "toSubmit" submissions, in order, running each one
+//	and posting its completion.  Stops early if the submission ring
+//	runs dry or the completion ring fills up; whatever is left stays
+//	queued for the next Enter.
+//
+//	The ring indices are written back once, at the end, so the whole
+//	batch costs one trap and a handful of word accesses.
+//----------------------------------------------------------------------
+
+int
+SyscallRing::Enter(AddrSpace *space, int toSubmit)
+{
+    int sqHead, sqTail, cqHead, cqTail;
+    int done;
+
+    if (!ReadWord(space, ctl + CtlSqHead, &sqHead)
+	    || !ReadWord(space, ctl + CtlSqTail, &sqTail)
+	    || !ReadWord(space, ctl + CtlCqHead, &cqHead)
+	    || !ReadWord(space, ctl + CtlCqTail, &cqTail))
+	return -1;
+
+    for (done = 0; done < toSubmit; done++) {
+	int sqe, cqe, code, userData, result;
+	int args[MaxSyscallArgs];
+	bool ok;
+
+	if (sqTail - sqHead <= 0 || cqTail - cqHead >= entries)
+	    break;
+	sqe = sq + (sqHead % entries) * sizeof(RingSqe);
+	cqe = cq + (cqTail % entries) * sizeof(RingCqe);
+
+	ok = ReadWord(space, sqe, &code) 
+		&& ReadWord(space, sqe + 4 * (1 + MaxSyscallArgs), &userData);
+	for (int i = 0; i < MaxSyscallArgs; i++)
+	    ok = ok && ReadWord(space, sqe + 4 * (1 + i), &args[i]);
+	if (!ok)
+	    break;
+
+	if (!Batchable(code) || !DispatchSyscall(code, args, &result)) {
+	    DEBUG('s', "Refused system call %d from a ring.\n", code);
+	    result = -1;
+	}
+	if (!WriteWord(space, cqe, userData) 
+		|| !WriteWord(space, cqe + 4, result))
+	    break;
+	sqHead++;
+	cqTail++;
+    }
+
+    if (!WriteWord(space, ctl + CtlSqHead, sqHead)
+	    || !WriteWord(space, ctl + CtlCqTail, cqTail))
+	return -1;
+    return done;
+}
@@ -0,0 +1,44 @@
+// ring.h 
+//	Data structures for batched system calls through rings shared
+//	between a user program and the kernel.
+//
+//	The program lays out a control block (RingCtl), a submission ring
+//	of RingSqe and a completion ring of RingCqe in its own memory, and
+//	registers them once with RingSetup.  It then fills in any number
+//	of submissions and hands them all to the kernel with a single
+//	Enter system call; the kernel runs them, in order, through the
+//	same dispatch table as trapped system calls, and posts one 
+//	completion for each.  See syscall.h for the layout.
+//
+//	Only the file system calls may be batched; anything that does not
+//	return to the caller (Exit, Halt) or that blocks on another
+//	process (Join) is refused with a -1 completion.
+
+#ifndef RING_H
+#define RING_H
+
+#include "copyright.h"
+#include "syscall.h"
+
+class AddrSpace;
+
+// The following class defines one address space's registered rings.
+// All of the ring state lives in user memory; this only records where.
+
+class SyscallRing {
+  public:
+    SyscallRing(int ctlAddr, int sqAddr, int cqAddr, int numEntries);
+
+    int Enter(AddrSpace *space, int toSubmit);
+				// run up to "toSubmit" queued submissions,
+				// returning how many were consumed, or -1
+				// if the rings are not addressable
+
+  private:
+    int ctl;			// user address of the RingCtl
+    int sq;			// user address of RingSqe[entries]
+    int cq;			// user address of RingCqe[entries]
+    int entries;
+};
+
+#endif // RING_H
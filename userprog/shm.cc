@@ -0,0 +1,238 @@
+// shm.cc 
+//	Routines to create shared memory segments, and to map them into
+//	and out of address spaces.
+
+#include "copyright.h"
+#include "system.h"
+#include "shm.h"
+
+//----------------------------------------------------------------------
+// ShmManager::ShmManager
+// 	Initialize an empty table of segments.
+//----------------------------------------------------------------------
+
+ShmManager::ShmManager()
+{
+    for (int id = 0; id < MaxShmSegments; id++)
+	segments[id].inUse = FALSE;
+}
+
+//----------------------------------------------------------------------
+// ShmManager::Find
+// 	Return the id of the segment made for "key", or -1.  Called with
+//	interrupts off.
+//----------------------------------------------------------------------
+
+int
+ShmManager::Find(int key)
+{
+    for (int id = 0; id < MaxShmSegments; id++)
+	if (segments[id].inUse && segments[id].key == key)
+	    return id;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// ShmManager::Create
+// 	Return the id of the segment for "key", making one of "size" 
+//	bytes, zeroed, if there is none yet.  Fails if there is one but
+//	it is smaller than "size", or if the table is full.  "space"
+//	holds the segment from now on, until it detaches it or exits.
+//
+//	The frames are found before the table is looked at again, since
+//	finding them may mean waiting for one of the caller's own pages
+//	to be written out.  If another process made the segment in the
+//	meantime, they are given back.
+//----------------------------------------------------------------------
+
+int
+ShmManager::Create(AddrSpace *space, int key, int size)
+{
+    int numPages = divRoundUp(size, PageSize);
+    int frames[MaxShmPages];
+    IntStatus oldLevel;
+    int id;
+
+    if (size <= 0 || numPages > MaxShmPages)
+	return -1;
+
+    oldLevel = interrupt->SetLevel(IntOff);
+    id = Find(key);
+    if (id != -1) {
+	if (segments[id].numPages >= numPages)
+	    Hold(space, id);
+	else
+	    id = -1;
+	(void) interrupt->SetLevel(oldLevel);
+	return id;
+    }
+    (void) interrupt->SetLevel(oldLevel);
+
+    for (int i = 0; i < numPages; i++) {
+	frames[i] = AllocFrame(space);
+	bzero(&(machine->mainMemory[frames[i] * PageSize]), PageSize);
+    }
+
+    oldLevel = interrupt->SetLevel(IntOff);
+    id = Find(key);
+    if (id != -1) {				// lost the race
+	if (segments[id].numPages < numPages)
+	    id = -1;
+    } else {
+	for (id = 0; id < MaxShmSegments && segments[id].inUse; id++)
+	    ;
+	if (id < MaxShmSegments) {
+	    ShmSegment *seg = &segments[id];
+
+	    seg->inUse = TRUE;
+	    seg->key = key;
+	    seg->numPages = numPages;
+	    seg->refs = 0;
+	    for (int i = 0; i < numPages; i++)
+		seg->frames[i] = frames[i];
+	    numPages = 0;			// the segment keeps them
+	} else
+	    id = -1;
+    }
+    if (id != -1)
+	Hold(space, id);
+    for (int i = 0; i < numPages; i++)
+	ReleaseFrame(frames[i]);
+    (void) interrupt->SetLevel(oldLevel);
+    DEBUG('u', "Shared memory key %d is segment %d\n", key, id);
+    return id;
+}
+
+//----------------------------------------------------------------------
+// ShmManager::Attach
+// 	Map segment "id" into "space", and return the virtual address it
+//	starts at; the same address, if it is already attached there.
+//	Returns -1 if there is no such segment.
+//----------------------------------------------------------------------
+
+int
+ShmManager::Attach(AddrSpace *space, int id)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    ShmSegment *seg;
+    int first;
+
+    if (id < 0 || id >= MaxShmSegments || !segments[id].inUse) {
+	(void) interrupt->SetLevel(oldLevel);
+	return -1;
+    }
+    seg = &segments[id];
+    first = space->shm_first[id];
+    if (first == -1) {
+	first = space->map_frames(seg->frames, seg->numPages);
+	for (int i = 0; i < seg->numPages; i++)
+	    HoldFrame(seg->frames[i]);
+	seg->refs++;
+	space->shm_first[id] = first;
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    return first * PageSize;
+}
+
+//----------------------------------------------------------------------
+// ShmManager::Hold
+// 	Note that ShmCreate returned segment "id" to "space", unless it
+//	had already.  Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+ShmManager::Hold(AddrSpace *space, int id)
+{
+    if (!space->shm_held[id]) {
+	space->shm_held[id] = TRUE;
+	segments[id].refs++;
+    }
+}
+
+//----------------------------------------------------------------------
+// ShmManager::Drop
+// 	Give up one reference to segment "id", freeing it if that was
+//	the last.  Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+ShmManager::Drop(int id)
+{
+    ShmSegment *seg = &segments[id];
+
+    if (--seg->refs == 0) {
+	DEBUG('u', "Freeing shared memory segment %d\n", id);
+	for (int i = 0; i < seg->numPages; i++)
+	    ReleaseFrame(seg->frames[i]);
+	seg->inUse = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// ShmManager::Unmap
+// 	Take segment "id" out of "space", freeing the segment if no one
+//	else holds it.  Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+ShmManager::Unmap(AddrSpace *space, int id)
+{
+    ShmSegment *seg = &segments[id];
+
+    space->unmap_frames(space->shm_first[id], seg->numPages);
+    space->shm_first[id] = -1;
+    for (int i = 0; i < seg->numPages; i++)
+	ReleaseFrame(seg->frames[i]);
+    Drop(id);
+}
+
+//----------------------------------------------------------------------
+// ShmManager::Detach
+// 	Unmap the segment attached at virtual address "addr" in "space",
+//	and let go of it if "space" made it.  Returns -1 if no segment 
+//	starts there, 0 otherwise.
+//----------------------------------------------------------------------
+
+int
+ShmManager::Detach(AddrSpace *space, int addr)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int result = -1;
+
+    for (int id = 0; id < MaxShmSegments; id++) {
+	if (space->shm_first[id] != -1 
+		&& space->shm_first[id] * PageSize == addr) {
+	    if (space->shm_held[id]) {
+		space->shm_held[id] = FALSE;
+		Drop(id);
+	    }
+	    Unmap(space, id);
+	    result = 0;
+	    break;
+	}
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    return result;
+}
+
+//----------------------------------------------------------------------
+// ShmManager::DetachAll
+// 	Unmap every segment attached to "space", and let go of every one
+//	it made, as it goes away.  Safe to call from ~AddrSpace.
+//----------------------------------------------------------------------
+
+void
+ShmManager::DetachAll(AddrSpace *space)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    for (int id = 0; id < MaxShmSegments; id++) {
+	if (space->shm_held[id]) {
+	    space->shm_held[id] = FALSE;
+	    Drop(id);
+	}
+	if (space->shm_first[id] != -1)
+	    Unmap(space, id);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
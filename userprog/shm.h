@@ -0,0 +1,72 @@
+// shm.h 
+//	Data structures for memory shared between user programs.
+//
+//	A segment is a few physical frames, found by a key that the
+//	cooperating programs agree on.  Attaching it maps those same 
+//	frames into the caller's page table, past the end of its program
+//	and stack, so what one process stores the others see at once,
+//	with no file I/O.
+//
+//	Frames are counted (see AllocFrame in addrspace.h): the segment
+//	holds one reference and every address space attached to it holds
+//	another.  A frame mapped into more than one place is never chosen
+//	for replacement, so shared pages stay in memory while attached.
+//
+//	Segments are counted too.  Every address space that ShmCreate 
+//	returned the segment to holds it, as does every one it is 
+//	attached to, until that space detaches it or exits.  The segment
+//	goes away, and its frames are freed, when the last of them lets
+//	go -- so a program that makes a segment and exits without ever
+//	attaching it does not leave it behind.
+//
+//	The table is only touched with interrupts off, since segments are
+//	detached from ~AddrSpace, which runs inside Scheduler::Run.
+
+#ifndef SHM_H
+#define SHM_H
+
+#include "copyright.h"
+
+class AddrSpace;
+
+#define MaxShmSegments	16	// segments in the system at once
+#define MaxShmPages	8	// largest segment, in pages
+
+// The following class defines one shared memory segment.
+
+class ShmSegment {
+  public:
+    bool inUse;
+    int key;			// what ShmCreate was called with
+    int numPages;
+    int frames[MaxShmPages];	// where the segment is in memory
+    int refs;			// address spaces that made or mapped it
+};
+
+// The following class defines the table of segments.
+
+class ShmManager {
+  public:
+    ShmManager();
+
+    int Create(AddrSpace *space, int key, int size);
+					// the id of the segment for "key",
+					// made "size" bytes long if new
+    int Attach(AddrSpace *space, int id);
+					// map segment "id" into "space";
+					// returns its virtual address
+    int Detach(AddrSpace *space, int addr);
+					// unmap the segment at "addr"
+    void DetachAll(AddrSpace *space);	// let go of everything, on exit
+
+  private:
+    int Find(int key);			// the id for "key", or -1
+    void Unmap(AddrSpace *space, int id);
+					// take segment "id" out of "space"
+    void Hold(AddrSpace *space, int id);
+					// "space" made segment "id"
+    void Drop(int id);			// one fewer space holds it
+    ShmSegment segments[MaxShmSegments];
+};
+
+#endif // SHM_H
@@ -8,17 +8,26 @@ static void MySynchWriteDone(int arg)
 {
 	((SynchConsole *)arg) -> WriteDone();
 }
-SynchConsole::SynchConsole(char *inputFile, char * outputFile)
+SynchConsole::SynchConsole(char *inputFile, char * outputFile, bool pollInput)
 {
-	console  = new Console(inputFile, outputFile, MySynchReadAvail, MySynchWriteDone, (int)this);	
+	console  = new Console(inputFile, outputFile, MySynchReadAvail, MySynchWriteDone, (int)this, pollInput);	
 	lock = new Lock("synchConsole");
+	readLock = new Lock("synchConsole read");
 	SynchReadAvail = new Semaphore("consoleInput", 0);
 	SynchWriteDone = new Semaphore("consoleOutput", 0);
+	outCount = 0;
+	flushing = FALSE;
+	inHead = inCount = lineBytes = 0;
 }
 SynchConsole::~SynchConsole()
 {
+	// Nachos is going away, so there is no waiting for the device;
+	// just get any buffered output onto the display.
+	if(outCount > 0 && !flushing)
+		console -> PutChars(outBuf, outCount);
 	delete	console;	
 	delete	lock; 
+	delete	readLock;
 	delete	SynchReadAvail;
 	delete	SynchWriteDone;
 }
@@ -27,10 +36,17 @@ SynchConsole::GetChar()
 {
 	char ch;
 
-	lock -> Acquire();
-	SynchReadAvail -> P();
-	ch = console -> GetChar();
-	lock -> Release();
+	readLock -> Acquire();
+	IntStatus oldLevel = interrupt -> SetLevel(IntOff);
+	while(inCount == 0)
+		SynchReadAvail -> P();
+	ch = inBuf[inHead];
+	inHead = (inHead + 1) % ConsoleBufferSize;
+	inCount--;
+	if(lineBytes > 0)
+		lineBytes--;
+	(void) interrupt -> SetLevel(oldLevel);
+	readLock -> Release();
 
 	return ch;
 }
@@ -38,13 +54,109 @@ void
 SynchConsole::PutChar(char ch)
 {
 	lock -> Acquire();
+	FlushBuffer();			// keep the output in order
 	console -> PutChar(ch);
 	SynchWriteDone -> P();
 	lock -> Release();
 }
+
+/**
+ * Queue size bytes of output.  The device gets the buffer when it fills
+ * up, and at the end of any write that contains a newline, so output 
+ * shows up a line at a time with one device operation per line.
+ */
+void
+SynchConsole::Write(char *buf, int size)
+{
+	bool newline = FALSE;
+
+	lock -> Acquire();
+	for(int i = 0; i < size; i++)
+	{
+		if(outCount == ConsoleBufferSize)
+			FlushBuffer();
+		outBuf[outCount++] = buf[i];
+		if(buf[i] == '\n')
+			newline = TRUE;
+	}
+	if(newline)
+		FlushBuffer();
+	lock -> Release();
+}
+
+/**
+ * Push out any buffered output, returning once the device is done with it.
+ * Called before a process exits and before Nachos halts.
+ */
+void
+SynchConsole::Flush()
+{
+	lock -> Acquire();
+	FlushBuffer();
+	lock -> Release();
+}
+
+void
+SynchConsole::FlushBuffer()
+{
+	ASSERT(lock -> isHeldByCurrentThread());
+	if(outCount == 0)
+		return;
+	flushing = TRUE;
+	console -> PutChars(outBuf, outCount);	// one interrupt for the lot
+	SynchWriteDone -> P();
+	flushing = FALSE;
+	outCount = 0;
+}
+/**
+ * Sleep until a complete line of input is buffered, then copy out as much
+ * of it as fits in size bytes.  Only the reading thread waits; the keyboard
+ * is polled while it does, and everyone else keeps running.
+ *
+ * Returns the number of bytes copied into buf.
+ */
+int
+SynchConsole::Read(char *buf, int size)
+{
+	int count;
+
+	readLock -> Acquire();
+	Flush();			// show any prompt before waiting
+
+	IntStatus oldLevel = interrupt -> SetLevel(IntOff);
+	if(lineBytes == 0)
+	{
+		console -> StartPolling();
+		while(lineBytes == 0)
+			SynchReadAvail -> P();
+		console -> StopPolling();
+	}
+	for(count = 0; count < size && count < lineBytes; count++)
+		buf[count] = inBuf[(inHead + count) % ConsoleBufferSize];
+	inHead = (inHead + count) % ConsoleBufferSize;
+	inCount -= count;
+	lineBytes -= count;
+	(void) interrupt -> SetLevel(oldLevel);
+
+	readLock -> Release();
+	return count;
+}
+
+/**
+ * Keyboard interrupt: move the new character into the line buffer.  A 
+ * newline, or running out of room, completes a line.
+ */
 void 
 SynchConsole::ReadAvail()
 {
+	char ch = console -> GetChar();
+
+	if(ch == EOF || inCount == ConsoleBufferSize)
+		return;
+	inBuf[(inHead + inCount) % ConsoleBufferSize] = ch;
+	inCount++;
+	if(ch == '\n' || inCount == ConsoleBufferSize)
+		lineBytes = inCount;
 	SynchReadAvail -> V();
 }
 void
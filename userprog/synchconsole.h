@@ -6,9 +6,11 @@
 #include "machine.h"
 #include "system.h"
 
+#define ConsoleBufferSize 256	// bytes of output held before a flush
+
 class SynchConsole{
 	public:
-		SynchConsole(char * inputFile = NULL, char * outputFile = NULL);
+		SynchConsole(char * inputFile = NULL, char * outputFile = NULL, bool pollInput = TRUE);
 		~SynchConsole();
 
 		char GetChar();
@@ -16,10 +18,34 @@ class SynchConsole{
 		void ReadAvail();
 		void WriteDone();
 
+		// Buffered output: Write queues bytes and hands them to the 
+		// device a whole buffer (or line) at a time; Flush pushes out 
+		// whatever is queued and waits for it to complete.
+		void Write(char *buf, int size);
+		void Flush();
+
+		// Line buffered input: Read sleeps until a whole line has
+		// been typed, then returns up to size bytes of it.  Bytes not
+		// taken stay buffered for the next Read.
+		int Read(char *buf, int size);
+
 	private:
+		void FlushBuffer();	// Flush, with lock held
+
 		Console *console;
 		Lock *lock;
+		Lock *readLock;			// one reader at a time
 		Semaphore * SynchReadAvail;
 		Semaphore * SynchWriteDone;
+
+		char outBuf[ConsoleBufferSize];	// output waiting for the device
+		int outCount;			// how much of outBuf is in use
+		bool flushing;			// is the device busy with outBuf?
+
+		char inBuf[ConsoleBufferSize];	// circular buffer of typed input
+		int inHead;			// oldest byte in inBuf
+		int inCount;			// bytes in inBuf
+		int lineBytes;			// bytes in inBuf up to the end of 
+						// the last complete line
 };
 #endif
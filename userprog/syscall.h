@@ -29,6 +29,22 @@
 #define SC_Close	8
 #define SC_Fork		9
 #define SC_Yield	10
+#define SC_AioRead	11
+#define SC_AioWrite	12
+#define SC_AioWait	13
+#define SC_RingSetup	14
+#define SC_Enter	15
+#define SC_Pipe		16
+#define SC_WaitAny	17
+#define SC_Dup		18
+#define SC_TraceDump	19
+#define SC_ShmCreate	20
+#define SC_ShmAttach	21
+#define SC_ShmDetach	22
+#define SC_Sleep	23
+#define SC_SetWeight	24
+#define SC_FutexWait	25
+#define SC_FutexWake	26
 
 
 #define MAXFILENAME 256
@@ -59,7 +75,8 @@ void Exit(int status);
 typedef int SpaceId;	
  
 /* Run the executable, stored in the Nachos file "name", and return the 
- * address space identifier
+ * address space identifier.  The program starts with every id the caller
+ * has open, under the same numbers.
  */
 //SpaceId Exec(char *name);
 SpaceId Exec(char* name, char* args[]);
@@ -68,6 +85,13 @@ SpaceId Exec(char* name, char* args[]);
  * Return the exit status.
  */
 int Join(SpaceId id); 	
+
+/* Only return once any one of the user programs this program started has
+ * finished, storing its exit status in "*status" (unless "status" is 0).
+ * Return its id, or -1 if there is nothing left to wait for.  Each program
+ * can only be waited for once, whether by Join or by WaitAny.
+ */
+SpaceId WaitAny(int *status);
  
 
 /* File system operations: Create, Open, Read, Write, Close
@@ -99,8 +123,10 @@ void Create(char *name);
  */
 OpenFileId Open(char *name);
 
-/* Write "size" bytes from "buffer" to the open file. */
-void Write(char *buffer, int size, OpenFileId id);
+/* Write "size" bytes from "buffer" to the open file.  
+ * Return the number of bytes written, or -1 on error.
+ */
+int Write(char *buffer, int size, OpenFileId id);
 
 /* Read "size" bytes from the open file into "buffer".  
  * Return the number of bytes actually read -- if the open file isn't
@@ -113,14 +139,130 @@ int Read(char *buffer, int size, OpenFileId id);
 /* Close the file, we're done reading and writing to it. */
 void Close(OpenFileId id);
 
+/* Return a second id for what "id" refers to: the lowest one not in use.
+ * Both share the file and its position; it stays open until both are 
+ * closed.  Closing ConsoleOutput first and then Dup'ing a file or the
+ * write end of a pipe sends what is written to the console there instead,
+ * including by programs started with Exec, which inherit every open id.
+ * Return -1 on error.
+ */
+OpenFileId Dup(OpenFileId id);
+
+/* Write the kernel's trace of the most recent system calls, of every
+ * program, to the host file named with -tr (or SYSTRACE); print it with
+ * bin/tracedump.  Return the number of calls written, or -1 if the file
+ * can't be written.
+ */
+int TraceDump();
+
+
+/* Shared memory: ShmCreate, ShmAttach and ShmDetach.  Programs that agree
+ * on a key can map the same memory, and see each other's stores to it at
+ * once.  A segment lasts until the last program using it detaches it or
+ * exits; it is not inherited by Exec.
+ */
+
+/* Return the id of the shared memory segment for "key", making it "size"
+ * bytes long, zeroed, if it doesn't exist yet.  Return -1 on error, or if
+ * the segment exists but is smaller than "size".
+ */
+int ShmCreate(int key, int size);
+
+/* Map segment "id" into this program, and return where it starts, or 0 on
+ * error.  It starts on a page boundary, past the stack.
+ */
+char *ShmAttach(int id);
+
+/* Unmap the segment that ShmAttach put at "addr", and let go of it if
+ * ShmCreate returned it to this program.  Return 0, or -1 on error.
+ */
+int ShmDetach(char *addr);
+
+/* Create a pipe.  "fds[0]" is set to an id to Read from and "fds[1]" to
+ * an id to Write to; what is written to one comes out of the other, in 
+ * order.  Read waits for data, and returns 0 once the pipe is empty and
+ * every write end is closed.  Write fails once every read end is closed.
+ * Both ends are inherited, under the same ids, by programs started with
+ * Exec.  Return 0, or -1 on error.
+ */
+int Pipe(OpenFileId fds[2]);
+
+
+/* Asynchronous file I/O: AioRead, AioWrite and AioWait.  These start a
+ * Read or Write of an open file (not the console) and return at once, so
+ * the program can compute while the disk works.  The buffer must not be
+ * touched until the request has been waited for.
+ */
+
+/* A handle on an asynchronous request. */
+typedef int AioId;
+
+/* Start reading "size" bytes from the open file into "buffer".  
+ * Return a handle, or -1 on error.
+ */
+AioId AioRead(char *buffer, int size, OpenFileId id);
+
+/* Start writing "size" bytes from "buffer" to the open file.  
+ * Return a handle, or -1 on error.
+ */
+AioId AioWrite(char *buffer, int size, OpenFileId id);
+
+/* Wait for request "aio" to finish, and return what Read or Write would
+ * have: the number of bytes transferred, or -1.
+ */
+int AioWait(AioId aio);
+
+
+/* Batched system calls: RingSetup and Enter.  A program can queue many
+ * Create/Open/Read/Write/Close calls in a submission ring in its own
+ * memory, and have the kernel run them all with one Enter, which posts
+ * a completion for each.  The ring indices count up forever; entry "i"
+ * lives in slot i % entries.  The program advances sqTail (after
+ * filling in the submission) and cqHead (after using the completion);
+ * the kernel advances sqHead and cqTail.
+ */
+
+/* One queued system call: "code" is an SC_ number, "args" are what would
+ * go in r4 - r7, and "userData" is handed back in the completion.
+ */
+typedef struct {
+    int code;
+    int args[4];
+    int userData;
+} RingSqe;
+
+/* The result of one queued call: what it would have returned in r2. */
+typedef struct {
+    int userData;
+    int result;
+} RingCqe;
+
+typedef struct {
+    int sqHead, sqTail;
+    int cqHead, cqTail;
+} RingCtl;
+
+/* Register the rings, each "entries" long.  Return 0, or -1 on error. */
+int RingSetup(RingCtl *ctl, RingSqe *sq, RingCqe *cq, int entries);
+
+/* Run up to "toSubmit" queued calls, in order; stop early if the
+ * submission ring empties or the completion ring fills.  Return how
+ * many were consumed, or -1 if no rings are registered.
+ */
+int Enter(int toSubmit);
+
 
 
 /* User-level thread operations: Fork and Yield.  To allow multiple
  * threads to run within a user program. 
+ *
+ * Threads share everything but their stacks.  A thread ends when its
+ * procedure returns or it calls Exit; the program ends with its last
+ * thread, and exits with that thread's status.
  */
 
 /* Fork a thread to run a procedure ("func") in the *same* address space 
- * as the current thread.
+ * as the current thread, on a stack of its own.
  */
 void Fork(void (*func)());
 
@@ -129,6 +271,43 @@ void Fork(void (*func)());
  */
 void Yield();		
 
+/* Block for "ticks" of simulated time, without running, so that other
+ * programs get the CPU meanwhile.  Sleep(0) just yields.
+ */
+void Sleep(int ticks);
+
+/* Set the weight of this program, and return the old one, or -1 if 
+ * "weight" is out of range.  Under the fair-share scheduler (nachos 
+ * -fair) programs get the CPU in proportion to their weights, however
+ * many threads each runs; the default weight is 1024.
+ */
+int SetWeight(int weight);
+
+
+/* User-level synchronization: FutexWait, FutexWake and CompareAndSwap.
+ *
+ * A lock or semaphore lives in a word of the program's memory (or of
+ * a shared memory segment) and is taken with CompareAndSwap, which does
+ * not trap; only a thread that has to wait, or one that has waiters to
+ * wake, calls into the kernel.
+ */
+
+/* Atomically store "value" in the word at "addr" if it holds "old".
+ * Return what the word held, so it succeeded if that is "old".
+ */
+int CompareAndSwap(int *addr, int old, int value);
+
+/* Sleep until a FutexWake on "addr", if the word there still holds
+ * "expected".  Return 0 once woken, or -1 at once if the word held
+ * something else (or "addr" is bad), in which case look again.
+ */
+int FutexWait(int *addr, int expected);
+
+/* Wake up to "count" of the threads sleeping on "addr", oldest first.
+ * Return how many were woken, or -1 if "addr" is bad.
+ */
+int FutexWake(int *addr, int count);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
@@ -0,0 +1,154 @@
+// syscalltable.cc 
+//	The system call dispatch table, and the per-syscall accounting.
+//
+//	The handlers themselves are in exception.cc; this file only
+//	knows how to find a handler by system call code, hand it its
+//	arguments, and time it.
+
+#include "copyright.h"
+#include "system.h"
+#include "syscalltable.h"
+#include "systrace.h"
+#include <sys/time.h>
+
+static SyscallEntry syscallTable[NumSyscalls];
+
+//----------------------------------------------------------------------
+// HostUsecs
+// 	Return the host's wall clock time, in microseconds.
+//----------------------------------------------------------------------
+
+static unsigned long long
+HostUsecs()
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (unsigned long long) now.tv_sec * 1000000 + now.tv_usec;
+}
+
+//----------------------------------------------------------------------
+// RegisterSyscall
+// 	Install the handler for one system call.
+//
+//	"code" is the system call code, from syscall.h
+//	"name" is the name to print it under
+//	"numArgs" is how many argument registers the handler takes
+//	"handler" is the routine to call
+//----------------------------------------------------------------------
+
+void
+RegisterSyscall(int code, char *name, int numArgs, SyscallHandler handler)
+{
+    SyscallEntry *entry;
+
+    ASSERT(code >= 0 && code < NumSyscalls);
+    ASSERT(numArgs >= 0 && numArgs <= MaxSyscallArgs);
+
+    entry = &syscallTable[code];
+    ASSERT(entry->handler == NULL);	// registered twice?
+    entry->name = name;
+    entry->numArgs = numArgs;
+    entry->handler = handler;
+    entry->calls = 0;
+    entry->ticks = entry->hostUsecs = 0;
+}
+
+//----------------------------------------------------------------------
+// DispatchSyscall
+// 	Run the handler for system call "code", with its arguments taken
+//	from r4 on, and account for it.
+//
+//	Returns FALSE if there is no handler for "code".
+//
+//	"code" is the system call code, from r2
+//	"result" is where to put the value to be returned in r2
+//----------------------------------------------------------------------
+
+bool
+DispatchSyscall(int code, int *result)
+{
+    int args[MaxSyscallArgs];
+
+    if (code < 0 || code >= NumSyscalls || syscallTable[code].handler == NULL)
+	return FALSE;
+
+    for (int i = 0; i < syscallTable[code].numArgs; i++)
+	args[i] = machine->ReadRegister(4 + i);
+    return DispatchSyscall(code, args, result);
+}
+
+//----------------------------------------------------------------------
+// DispatchSyscall
+// 	Run the handler for system call "code" on arguments that have
+//	already been fetched -- from the registers, or from a submission
+//	ring (see ring.cc) -- and account for it, and trace it.  Handlers
+//	that do not return (Exit, Halt) are counted but not timed.
+//
+//	Returns FALSE if there is no handler for "code".
+//----------------------------------------------------------------------
+
+bool
+DispatchSyscall(int code, int *args, int *result)
+{
+    SyscallEntry *entry;
+    unsigned long long startTicks, startUsecs;
+    unsigned int seq;
+
+    if (code < 0 || code >= NumSyscalls || syscallTable[code].handler == NULL)
+	return FALSE;
+    entry = &syscallTable[code];
+
+    DEBUG('s', "%s, initiated by user program.\n", entry->name);
+    entry->calls++;
+    startTicks = stats->totalTicks;
+    startUsecs = HostUsecs();
+    seq = syscallTrace->Enter(currentThread->getID(), code, entry->numArgs,
+		args);
+
+    *result = (*entry->handler)(args);
+
+    syscallTrace->Exit(seq, *result);
+
+    entry->ticks += stats->totalTicks - startTicks;
+    entry->hostUsecs += HostUsecs() - startUsecs;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SyscallName
+// 	Return the name system call "code" was registered under, or NULL.
+//----------------------------------------------------------------------
+
+char *
+SyscallName(int code)
+{
+    if (code < 0 || code >= NumSyscalls)
+	return NULL;
+    return syscallTable[code].name;
+}
+
+//----------------------------------------------------------------------
+// PrintSyscallStats
+// 	Print the per-syscall cost profile, when Nachos halts.
+//----------------------------------------------------------------------
+
+void
+PrintSyscallStats()
+{
+    bool any = FALSE;
+
+    for (int code = 0; code < NumSyscalls; code++) {
+	SyscallEntry *entry = &syscallTable[code];
+
+	if (entry->handler == NULL || entry->calls == 0)
+	    continue;
+	if (!any)
+	    printf("System calls:\n");
+	any = TRUE;
+	printf("  %-8s calls %d, ticks %llu (avg %llu), host usecs %llu "
+	    "(avg %llu)\n", entry->name, entry->calls, entry->ticks, 
+	    entry->ticks / entry->calls, entry->hostUsecs,
+	    entry->hostUsecs / entry->calls);
+    }
+}
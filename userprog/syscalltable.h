@@ -0,0 +1,57 @@
+// syscalltable.h 
+//	Data structures for dispatching system calls from user programs.
+//
+//	ExceptionHandler looks the system call code up in a table
+//	indexed by the SC_* constants in syscall.h.  Each entry carries
+//	the handler, how many argument registers it takes, and the
+//	accounting for every call made through it: how many times it
+//	was called, and how long it took in simulated ticks and in real
+//	(host) time.  Every call is also recorded in the trace ring
+//	(see systrace.h).
+//
+//	To add a system call, give it a code in syscall.h and a stub in
+//	start.s, and register a handler for it in RegisterSyscalls.
+
+#ifndef SYSCALLTABLE_H
+#define SYSCALLTABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define NumSyscalls	64	// size of the dispatch table
+#define MaxSyscallArgs	4	// arguments are passed in r4 - r7
+
+// A system call handler.  "args" holds the argument registers (r4 on);
+// the return value is written back into r2.
+typedef int (*SyscallHandler)(int *args);
+
+// The following class defines one slot of the dispatch table.
+
+class SyscallEntry {
+  public:
+    char *name;			// for printing; NULL if the slot is empty
+    int numArgs;		// how many argument registers to marshal
+    SyscallHandler handler;	// the kernel routine to call
+
+    int calls;			// number of times this was called
+    unsigned long long ticks;	// total simulated time, for the calls
+				// that returned
+    unsigned long long hostUsecs; // total host time, in microseconds
+};
+
+extern void RegisterSyscalls();		// fill in the dispatch table,
+					// defined in exception.cc
+extern void RegisterSyscall(int code, char *name, int numArgs, 
+			SyscallHandler handler);
+					// set up one slot of the table
+extern bool DispatchSyscall(int code, int *result);
+					// marshal the arguments, run and
+					// account for one system call; FALSE
+					// if "code" has no handler
+extern bool DispatchSyscall(int code, int *args, int *result);
+					// same, with the arguments already
+					// in hand (batched calls)
+extern char *SyscallName(int code);	// NULL if "code" has no handler
+extern void PrintSyscallStats();	// print the per-syscall profile
+
+#endif // SYSCALLTABLE_H
@@ -0,0 +1,150 @@
+// systrace.cc 
+//	Routines to record system calls in the trace ring, and to write
+//	the ring out.
+//
+//	A record is claimed when the call is dispatched, and completed
+//	when it returns.  A call that blocks (Join, Read of a pipe) may
+//	return after the ring has come round and reused its record for
+//	a later call; each record carries its sequence number, so that
+//	the late return is simply not recorded.
+
+#include "copyright.h"
+#include "system.h"
+#include "systrace.h"
+#include "syscalltable.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+//----------------------------------------------------------------------
+// SyscallTrace::SyscallTrace
+// 	Initialize an empty trace ring.
+//
+//	"file" is the host file to dump the ring to when Nachos halts,
+//	or NULL to dump it only when asked, to DefaultTraceFile
+//----------------------------------------------------------------------
+
+SyscallTrace::SyscallTrace(char *file)
+{
+    ASSERT((TraceRingSize & (TraceRingSize - 1)) == 0);
+    next = 0;
+    fileName = file;
+}
+
+//----------------------------------------------------------------------
+// SyscallTrace::Enter
+// 	Record that process "pid" is making system call "code" with the
+//	first "numArgs" of "args".  Returns the number to pass to Exit.
+//----------------------------------------------------------------------
+
+unsigned int
+SyscallTrace::Enter(int pid, int code, int numArgs, int *args)
+{
+    unsigned int seq = next++;
+    TraceRecord *rec = &ring[seq & (TraceRingSize - 1)];
+
+    rec->seq = seq;
+    rec->pid = pid;
+    rec->code = code;
+    rec->numArgs = numArgs;
+    for (int i = 0; i < numArgs; i++)
+	rec->args[i] = args[i];
+    rec->result = 0;
+    rec->returned = 0;
+    rec->entryTicks = stats->totalTicks;
+    rec->exitTicks = 0;
+    return seq;
+}
+
+//----------------------------------------------------------------------
+// SyscallTrace::Exit
+// 	Record that system call "seq" returned "result", unless its 
+//	record has been overwritten in the meantime.
+//----------------------------------------------------------------------
+
+void
+SyscallTrace::Exit(unsigned int seq, int result)
+{
+    TraceRecord *rec = &ring[seq & (TraceRingSize - 1)];
+
+    if (rec->seq != seq)
+	return;
+    rec->result = result;
+    rec->returned = 1;
+    rec->exitTicks = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// WriteAll
+// 	Write "size" bytes from "buffer" to the host file "fd".  Returns
+//	FALSE if they could not all be written.
+//----------------------------------------------------------------------
+
+static bool
+WriteAll(int fd, void *buffer, int size)
+{
+    return write(fd, buffer, size) == size;
+}
+
+//----------------------------------------------------------------------
+// SyscallTrace::Dump
+// 	Write the ring, oldest record first, to the trace file named
+//	with -tr, or to DefaultTraceFile.  Returns how many records were
+//	written, or -1 if the file could not be.
+//
+//	Any user program can get here, with TraceDump, so a file that
+//	can't be opened or written is an error for the caller rather
+//	than an assertion (see OpenForWrite in sysdep.cc).
+//----------------------------------------------------------------------
+
+int
+SyscallTrace::Dump()
+{
+    char *name = (fileName != NULL) ? fileName : (char *) DefaultTraceFile;
+    TraceHeader header;
+    char names[NumSyscalls][TraceNameLen];
+    unsigned int first;
+    bool ok;
+    int fd;
+
+    first = (next > TraceRingSize) ? next - TraceRingSize : 0;
+    header.traceMagic = TRACEMAGIC;
+    header.numNames = NumSyscalls;
+    header.numRecords = next - first;
+    header.dropped = first;
+    for (int code = 0; code < NumSyscalls; code++) {
+	char *callName = SyscallName(code);
+
+	bzero(names[code], TraceNameLen);
+	if (callName != NULL)
+	    strncpy(names[code], callName, TraceNameLen - 1);
+    }
+
+    if ((fd = open(name, O_WRONLY|O_CREAT|O_TRUNC, 0666)) < 0) {
+	DEBUG('s', "Cannot open trace file %s.\n", name);
+	return -1;
+    }
+    ok = WriteAll(fd, &header, sizeof(header)) 
+	    && WriteAll(fd, names, sizeof(names));
+    for (unsigned int seq = first; ok && seq != next; seq++)
+	ok = WriteAll(fd, &ring[seq & (TraceRingSize - 1)], 
+		sizeof(TraceRecord));
+    close(fd);
+    if (!ok) {
+	DEBUG('s', "Cannot write trace file %s.\n", name);
+	return -1;
+    }
+    DEBUG('s', "Dumped %d system calls to %s.\n", header.numRecords, name);
+    return header.numRecords;
+}
+
+//----------------------------------------------------------------------
+// SyscallTrace::Halt
+// 	Nachos is halting: write the trace out if -tr named a file.
+//----------------------------------------------------------------------
+
+void
+SyscallTrace::Halt()
+{
+    if (fileName != NULL)
+	Dump();
+}
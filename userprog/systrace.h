@@ -0,0 +1,45 @@
+// systrace.h 
+//	Data structures for tracing the system calls of user programs.
+//
+//	Every system call, as it is dispatched, fills in a fixed-size
+//	binary record in a ring: the pid, the call and its arguments,
+//	and, once it returns, the result and the time spent.  Filling in
+//	a record is a few stores and takes no lock (nothing in it can
+//	cause a context switch), so the trace is always on.  When the
+//	ring is full the oldest records are overwritten.
+//
+//	The ring is written out as a trace file (see ../bin/tracefmt.h)
+//	by the TraceDump system call, and when Nachos halts if a file
+//	was named with -tr.  ../bin/tracedump prints it.
+
+#ifndef SYSTRACE_H
+#define SYSTRACE_H
+
+#include "copyright.h"
+#include "tracefmt.h"
+
+#define TraceRingSize	1024		// records kept; a power of two
+#define DefaultTraceFile "SYSTRACE"	// where TraceDump writes, without -tr
+
+// The following class defines the trace ring.
+
+class SyscallTrace {
+  public:
+    SyscallTrace(char *file);	// "file" is from -tr; NULL if none
+
+    unsigned int Enter(int pid, int code, int numArgs, int *args);
+				// record the start of a system call,
+				// returning its sequence number
+    void Exit(unsigned int seq, int result);
+				// record that call "seq" returned
+
+    int Dump();			// write the ring to the trace file
+    void Halt();		// Nachos is halting; dump if -tr was given
+
+  private:
+    TraceRecord ring[TraceRingSize];
+    unsigned int next;		// sequence number of the next call
+    char *fileName;		// from -tr, or NULL
+};
+
+#endif // SYSTRACE_H